@@ -102,10 +102,17 @@ build_web() {
         "src/pieces/queen.cpp"
         "src/pieces/rook.cpp"
         "src/board/chessboard.cpp"
+        "src/board/bitboard.cpp"
+        "src/board/zobrist.cpp"
+        "src/board/psqt.cpp"
+        "src/board/nnue.cpp"
         "src/game/game.cpp"
         "src/players/player.cpp"
         "src/players/human.cpp"
         "src/players/computer.cpp"
+        "src/ai/advanced_ai.cpp"
+        "src/ai/endgame.cpp"
+        "src/ai/ai_factory.cpp"
         "src/observers/textobserver.cpp"
         "src/web/web_interface.cpp"
         "src/main.cc"
@@ -119,6 +126,7 @@ build_web() {
         "-Iinclude/players"
         "-Iinclude/observers"
         "-Iinclude/web"
+        "-Iinclude/ai"
     )
     
     EMCC_FLAGS=(
@@ -1,11 +1,16 @@
 #ifndef ADVANCED_AI_H
 #define ADVANCED_AI_H
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <chrono>
 #include <climits>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include "chessboard.h"
+#include "endgame.h"
 #include "player.h"
 
 // Forward declarations
@@ -43,6 +48,21 @@ public:
         }
     };
 
+    // One line of a multi-PV analysis
+    struct AnalysisLine {
+        int depth;
+        int score; // centipawns from white's point of view
+        int mateIn; // moves until mate, positive when white mates, 0 without a forced mate
+        std::vector<Move> pv;
+    };
+
+    // A search parameter open to tuning, with the range it may take
+    struct Parameter {
+        std::string name;
+        int value;
+        int min, max;
+    };
+
     // Transposition table entry types
     enum class NodeType {
         EXACT,      // Exact score
@@ -57,47 +77,154 @@ public:
         int score;
         Move bestMove;
         NodeType type;
+        uint8_t generation; // search that last stored or used the entry
+        
+        TTEntry() : hash(0), depth(-1), score(0), type(NodeType::EXACT), generation(0) {}
+        TTEntry(uint64_t h, int d, int s, Move m, NodeType t, uint8_t g) 
+            : hash(h), depth(d), score(s), bestMove(m), type(t), generation(g) {}
+    };
+    
+    // Evaluation cache entry
+    struct EvalEntry {
+        uint64_t key;
+        int score;
+        
+        EvalEntry() : key(0), score(0) {}
+    };
+    
+    // Pawn hash entry: pawn structure score, plus the shield of the king squares it was last used with
+    struct PawnEntry {
+        uint64_t key;
+        int score;
+        int kingSquare[2]; // [white = 0, black = 1], -1 until computed
+        int shield[2];
+        
+        PawnEntry() : key(0), score(0), kingSquare{-1, -1}, shield{0, 0} {}
+    };
+    
+    // Material table entry: terms that only depend on how much material each side has
+    struct MaterialEntry {
+        static const int NORMAL_SCALE = 64; // scale factor that leaves the evaluation as it is
+        
+        uint64_t key;
+        int imbalance; // from white's point of view
+        int scaleFactor[2]; // [white = 0, black = 1], out of NORMAL_SCALE, applied while that side is ahead
+        bool draw; // neither side has the material to mate
+        Endgames::Evaluator endgame; // replaces the general evaluation in endings it plays badly, or nullptr
+        bool endgameStrongIsWhite;
         
-        TTEntry() : hash(0), depth(-1), score(0), type(NodeType::EXACT) {}
-        TTEntry(uint64_t h, int d, int s, Move m, NodeType t) 
-            : hash(h), depth(d), score(s), bestMove(m), type(t) {}
+        MaterialEntry() : key(0), imbalance(0), scaleFactor{NORMAL_SCALE, NORMAL_SCALE}, draw(false),
+                          endgame(nullptr), endgameStrongIsWhite(false) {}
+    };
+    
+    // Attack maps of both sides, built once per evaluation and shared by the
+    // mobility, king safety and threat terms; arrays are [white = 0, black = 1]
+    struct AttackInfo {
+        Bitboard byType[2][6]; // squares attacked by a side's pieces of one type (p, n, b, r, q, k)
+        Bitboard all[2]; // squares attacked by a side
+        int mobility[2]; // mobility score of a side's pieces
+        int kingAttackers[2]; // enemy pieces attacking the zone around a side's king
+        int kingAttackWeight[2]; // weighted count of the enemy attacks on that zone
     };
 
 private:
     // Algorithm parameters
     int maxDepth;
-    int timeLimit; // milliseconds
+    int timeLimit; // milliseconds, upper bound on the time spent per move
+    std::atomic<int> moveTimeLimit; // milliseconds allotted to the current move
+    
+    // Game clock, reported by the Game before each move (-1 when untimed)
+    int clockTimeLeft;
+    int clockIncrement;
+    int clockMovesToGo;
     bool useIterativeDeepening;
     bool useTranspositionTable;
     bool useNullMovePruning;
     bool useQuiescenceSearch;
     bool usePrincipalVariationSearch;
+    bool useLazyEvaluation;
+    bool useNNUE; // evaluate with the loaded network, if there is one, instead of the handcrafted terms
+    bool deterministic; // stop on node/depth limits only, never on time
+    bool verbose; // print each completed iteration and the statistics of every move
+    uint64_t nodeLimit; // 0 means unlimited
+    int multiPV; // lines reported by analyze()
+    mutable std::atomic<bool> searchStopped;
+    
+    // Pondering: after its move the engine searches the reply it expects on the
+    // opponent's time, without a time limit until the reply is known
+    bool usePondering;
+    std::atomic<bool> pondering;
+    std::thread ponderThread;
+    std::unique_ptr<ChessBoard> ponderBoard; // position after the expected reply
+    uint64_t ponderHash;
+    Move ponderMove; // expected reply, from the last PV
+    Move ponderResult;
+    std::chrono::steady_clock::time_point ponderStart;
+    
+    int lastScore; // score of the last completed iteration, from white's point of view
     
     // Search statistics
-    mutable int nodesSearched;
-    mutable int transpositionHits;
-    mutable int alphaBetaCutoffs;
-    mutable int quiescenceNodes;
+    mutable uint64_t nodesSearched;
+    mutable uint64_t transpositionHits;
+    mutable uint64_t alphaBetaCutoffs;
+    mutable uint64_t quiescenceNodes;
+    mutable uint64_t evalCacheHits;
+    mutable uint64_t evaluations; // calls to evaluatePosition
+    mutable uint64_t lazyEvaluations; // of those, answered from material and piece-square values alone
+    mutable uint64_t pawnTableProbes;
+    mutable uint64_t pawnTableHits;
     
-    // Transposition table
-    mutable std::unordered_map<uint64_t, TTEntry> transpositionTable;
-    const size_t MAX_TT_SIZE = 1000000; // Maximum entries
-    
-    // Zobrist hashing for position encoding
-    static uint64_t zobristTable[8][8][12]; // [square][piece]
-    static uint64_t zobristBlackToMove;
-    static uint64_t zobristCastling[4];
-    static uint64_t zobristEnPassant[8];
-    static bool zobristInitialized;
-    
-    // Piece-square tables for evaluation
-    static const int PAWN_TABLE[8][8];
-    static const int KNIGHT_TABLE[8][8];
-    static const int BISHOP_TABLE[8][8];
-    static const int ROOK_TABLE[8][8];
-    static const int QUEEN_TABLE[8][8];
-    static const int KING_MIDDLEGAME_TABLE[8][8];
-    static const int KING_ENDGAME_TABLE[8][8];
+    // Transposition table: fixed size, buckets of two entries indexed by the low bits of the hash
+    mutable std::vector<TTEntry> transpositionTable;
+    static const size_t TT_SIZE = 1 << 19; // entries, a power of two
+    mutable uint8_t ttGeneration; // advanced every move, entries from older searches are replaced first
+    
+    // Evaluation cache: static evals by position key, always replaced on a miss.
+    // Each engine searches on one thread at a time, so it needs no locking.
+    mutable std::vector<EvalEntry> evalCache;
+    static const size_t EVAL_CACHE_SIZE = 1 << 16; // entries, a power of two
+    uint32_t evalCacheNetwork; // NNUE::generation() of the network the cache was filled with, 0 for the handcrafted evaluation
+    
+    // Material table: material terms by material key, always replaced on a miss
+    mutable std::vector<MaterialEntry> materialTable;
+    static const size_t MATERIAL_TABLE_SIZE = 1 << 13; // entries, a power of two
+    
+    // Pawn hash table: pawn structure terms by pawn-only key, always replaced on a miss
+    mutable std::vector<PawnEntry> pawnTable;
+    static const size_t PAWN_TABLE_SIZE = 1 << 14; // entries, a power of two
+    
+    // Principal variation expected from the position after the opponent's reply,
+    // reused when the game follows it
+    std::vector<Move> previousPV;
+    uint64_t previousPVHash;
+    
+    // Mate scores: mated at ply N scores -(MATE_SCORE - N) for the mated side
+    static const int MATE_SCORE = 10000;
+    static const int MATE_BOUND = 9000; // scores beyond this are mate scores
+    
+    // Search extensions, reductions and pruning: tunable, so each engine has
+    // its own values and differently tuned engines can play each other
+    int singularMinDepth; // shallowest node that tries a singular extension
+    int singularMargin; // centipawns per ply of depth the other moves must fall short of the TT move by
+    int iirMinDepth; // shallowest node reduced for lacking a TT move
+    int probCutMinDepth; // shallowest node that tries ProbCut
+    int probCutReduction; // plies by which ProbCut's verification search is reduced
+    int probCutMargin; // centipawns beyond the bound a capture must reach
+    int historyBonusScale; // history bonus of a quiet cutoff per ply of depth squared
+    
+    // Names and ranges of the tunable parameters (see getParameters)
+    struct ParameterInfo {
+        const char* name;
+        int AdvancedAI::*value;
+        int min, max;
+    };
+    static const ParameterInfo TUNABLE_PARAMETERS[];
+    
+    // Lazy evaluation: centipawns the terms beyond material and piece-square values are assumed never to exceed
+    static const int LAZY_EVAL_MARGIN = 400;
+    
+    // Piece values for exchanges and move ordering
+    static const int PIECE_VALUES[6];
     
     // Opening book
     std::unordered_map<uint64_t, std::vector<Move>> openingBook;
@@ -105,64 +232,161 @@ private:
     // Killer moves heuristic (best moves at each depth)
     mutable Move killerMoves[64][2]; // [depth][killer_slot]
     
-    // History heuristic (move ordering)
+    // History heuristic (move ordering), scores saturate at +-HISTORY_MAX
     mutable int historyTable[8][8][8][8]; // [from][to] move scores
+    static const int HISTORY_MAX = 16384;
+    
+    // Counter-move heuristic: the quiet move that last refuted each move
+    mutable Move counterMoves[12][64]; // [piece][to square] of the refuted move
+    
+    // Continuation history: quiet move scores given the moves 1 and 2 plies earlier
+    mutable std::vector<int16_t> continuationHistory; // [previous piece][previous to][piece][to]
+    
+    // Search stack: the move made at each ply, so a node can see the moves leading to it
+    static const int MAX_PLY = 128;
+    struct PlyInfo {
+        Move move;
+        int piece; // piece index of the moving piece, -1 when unknown
+        bool capture; // the move captured a piece
+        Move excludedMove; // move skipped by a singular extension search of this node
+        int extensions; // plies of extension spent on the path to this node
+    };
+    mutable PlyInfo searchStack[MAX_PLY];
+    mutable int rootDepth; // depth of the current iteration, also the per-path extension budget
+    
+    // Staged move picker (see nextMove)
+    enum class PickStage {
+        TT_MOVE, CAPTURES_INIT, GOOD_CAPTURES, KILLERS, QUIETS_INIT, QUIETS, BAD_CAPTURES, DONE
+    };
+    
+    struct MovePicker {
+        PickStage stage;
+        bool whiteToMove;
+        bool capturesOnly; // quiescence search: good captures only
+        int depth;
+        int ply;
+        Move ttMove;
+        Move counterMove; // set once the counter move has been tried
+        std::vector<Move> moves; // moves of the current stage
+        std::vector<Move> badCaptures; // captures with negative SEE, searched last
+        size_t index;
+        
+        MovePicker(bool whiteToMove, int depth, int ply, Move ttMove, bool capturesOnly = false);
+    };
 
 public:
     explicit AdvancedAI(bool isWhite, int difficulty = 4);
-    virtual ~AdvancedAI() = default;
+    virtual ~AdvancedAI();
     
     // Player interface
     bool makeMove(ChessBoard& board) override;
+    void updateClock(int timeLeftMs, int incrementMs, int movesToGo) override;
+    void setPondering(bool enable) override { usePondering = enable; }
+    void gameOver() override { stopPondering(); }
     
     // Configuration methods
     void setMaxDepth(int depth) { maxDepth = depth; }
     void setTimeLimit(int ms) { timeLimit = ms; }
+    void setNodeLimit(uint64_t nodes) { nodeLimit = nodes; }
+    void setDeterministic(bool enable) { deterministic = enable; }
+    void setMultiPV(int lines) { multiPV = lines < 1 ? 1 : lines; }
     void enableIterativeDeepening(bool enable) { useIterativeDeepening = enable; }
     void enableTranspositionTable(bool enable) { useTranspositionTable = enable; }
     void enableNullMovePruning(bool enable) { useNullMovePruning = enable; }
     void enableQuiescenceSearch(bool enable) { useQuiescenceSearch = enable; }
     void enablePrincipalVariationSearch(bool enable) { usePrincipalVariationSearch = enable; }
+    void enableLazyEvaluation(bool enable) { useLazyEvaluation = enable; }
+    void enableNNUE(bool enable) { useNNUE = enable; } // takes effect when a network is loaded with NNUE::load
+    void setVerbose(bool enable) { verbose = enable; }
+    
+    // Tunable search parameters, by name
+    std::vector<Parameter> getParameters() const;
+    bool setParameter(const std::string& name, int value); // clamps the value to the parameter's range; false for an unknown name
+    
+    // Forgets everything learned from the previous game: tables, histories and the expected line
+    void newGame();
+    
+    // Analysis: the best multiPV moves for this engine's side, each with its line
+    std::vector<AnalysisLine> analyze(ChessBoard& board);
+    static std::string moveToString(const Move& move);
     
     // Statistics
     void printSearchStatistics() const;
     void clearStatistics() const;
+    uint64_t getNodesSearched() const { return nodesSearched + quiescenceNodes; }
+    int getLastScore() const { return lastScore; } // centipawns from white's point of view, of the last move's deepest completed iteration
 
 private:
     // Core search algorithms
     Move findBestMove(ChessBoard& board);
-    int minimax(ChessBoard& board, int depth, int alpha, int beta, bool maximizing, 
+    void prepareSearch();
+    int searchRoot(ChessBoard& board, int depth, const std::vector<Move>& rootMoves, Move& bestMove,
+                   std::chrono::steady_clock::time_point startTime) const;
+    int minimax(ChessBoard& board, int depth, int alpha, int beta, bool maximizing, int ply,
                 std::chrono::steady_clock::time_point startTime) const;
     int principalVariationSearch(ChessBoard& board, int depth, int alpha, int beta, 
-                                bool maximizing, std::chrono::steady_clock::time_point startTime) const;
+                                bool maximizing, int ply, std::chrono::steady_clock::time_point startTime) const;
     int quiescenceSearch(ChessBoard& board, int alpha, int beta, bool maximizing, 
                         std::chrono::steady_clock::time_point startTime) const;
     
     // Move generation and ordering
-    std::vector<Move> generateMoves(ChessBoard& board, bool capturesOnly = false) const;
+    std::vector<Move> generateMoves(ChessBoard& board, bool whiteToMove, bool capturesOnly = false) const;
+    void generateCaptureMoves(ChessBoard& board, bool whiteToMove, std::vector<Move>& moves) const;
+    void generateQuietMoves(ChessBoard& board, bool whiteToMove, std::vector<Move>& moves) const;
+    bool canCastle(ChessBoard& board, bool whiteToMove, bool kingside) const;
+    bool isPseudoLegal(const Move& move, ChessBoard& board, bool whiteToMove) const;
+    bool isLegal(const Move& move, ChessBoard& board, bool whiteToMove) const;
+    bool inCheck(ChessBoard& board, bool white) const;
+    bool nextMove(MovePicker& picker, ChessBoard& board, Move& move) const;
+    bool isKiller(const Move& move, int depth) const;
+    int quietMoveScore(const Move& move, ChessBoard& board, int ply) const;
     void orderMoves(std::vector<Move>& moves, ChessBoard& board, int depth, Move ttMove) const;
     int scoreMoveForOrdering(const Move& move, ChessBoard& board, int depth, Move ttMove) const;
+    int staticExchangeEvaluation(const Move& move, ChessBoard& board) const;
     
     // Evaluation function
-    int evaluatePosition(ChessBoard& board) const;
-    int evaluateMaterial(ChessBoard& board) const;
-    int evaluatePositional(ChessBoard& board) const;
+    int evaluatePosition(ChessBoard& board, int alpha = INT_MIN, int beta = INT_MAX) const;
+    bool usingNNUE() const { return useNNUE && NNUE::isLoaded(); }
+    int computeEvaluation(ChessBoard& board, const MaterialEntry& material) const;
+    const MaterialEntry& probeMaterial(const ChessBoard& board) const;
+    static void computeMaterial(const ChessBoard& board, MaterialEntry& entry);
     int evaluatePawnStructure(ChessBoard& board) const;
-    int evaluateKingSafety(ChessBoard& board) const;
-    int evaluateMobility(ChessBoard& board) const;
-    bool isEndgame(ChessBoard& board) const;
+    static int computePawnStructure(const ChessBoard& board);
+    static int computePawnShield(const ChessBoard& board, bool isWhite, int kingSquare);
+    static void computeAttacks(const ChessBoard& board, AttackInfo& attacks);
+    static int evaluateKingSafety(const ChessBoard& board, const AttackInfo& attacks);
+    static int evaluateMobility(const AttackInfo& attacks);
+    static int evaluateThreats(const ChessBoard& board, const AttackInfo& attacks);
     
     // Transposition table
-    uint64_t computeZobristHash(ChessBoard& board) const;
-    void storeInTranspositionTable(uint64_t hash, int depth, int score, 
+    uint64_t computeZobristHash(ChessBoard& board, bool whiteToMove) const;
+    void storeInTranspositionTable(uint64_t hash, int depth, int ply, int score, 
                                   Move bestMove, NodeType type) const;
-    bool probeTranspositionTable(uint64_t hash, int depth, int alpha, int beta, 
+    bool probeTranspositionTable(uint64_t hash, int depth, int ply, int alpha, int beta, 
                                 int& score, Move& bestMove) const;
+    TTEntry* findTTEntry(uint64_t hash) const;
+    int transpositionTableUsage() const;
+    
+    // Principal variation
+    std::vector<Move> extractPrincipalVariation(ChessBoard& board, const Move& firstMove, int maxLength) const;
+    void savePrincipalVariation(ChessBoard& board, const std::vector<Move>& pv);
+    void reusePrincipalVariation(ChessBoard& board, std::vector<Move>& rootMoves);
+    
+    // Pondering
+    void startPondering(ChessBoard& board);
+    bool finishPondering(ChessBoard& board, Move& bestMove);
+    void stopPondering();
     
     // Utility functions
+    int allocateMoveTime() const;
     bool isTimeUp(std::chrono::steady_clock::time_point startTime) const;
+    bool shouldStopSearch(std::chrono::steady_clock::time_point startTime) const;
+    void resetSearchState() const;
     void updateKillerMoves(const Move& move, int depth) const;
-    void updateHistoryTable(const Move& move, int depth) const;
+    void updateHistoryTable(const Move& move, ChessBoard& board, int ply, int bonus) const;
+    void updateQuietHistories(const Move& bestMove, const Move* quietsSearched, int quietCount,
+                              ChessBoard& board, int depth, int ply) const;
+    void ageHistory() const;
     Move convertToInternalMove(int fromRow, int fromCol, int toRow, int toCol, char promotion = 'x') const;
     bool isCapture(const Move& move, ChessBoard& board) const;
     bool isCheck(const Move& move, ChessBoard& board) const;
@@ -171,8 +395,7 @@ private:
     void initializeOpeningBook();
     Move getOpeningMove(ChessBoard& board) const;
     
-    // Static initialization
-    static void initializeZobristTable();
+    // Static helpers
     static int getPieceIndex(char pieceType, bool isWhite);
 };
 
@@ -4,6 +4,8 @@
 #include <memory>
 #include "player.h"
 
+class AdvancedAI;
+
 /**
  * @brief Factory class for creating different types of AI players
  * 
@@ -36,6 +38,16 @@ public:
                                                     int timeLimit = 5000,
                                                     bool useAdvancedFeatures = true);
     
+    /**
+     * @brief Creates an advanced AI configured for multi-PV analysis
+     * 
+     * @param isWhite Side to move in the analysed position
+     * @param lines Number of best moves to report
+     * @param timeLimit Time limit in milliseconds
+     * @return std::unique_ptr<AdvancedAI> Engine to call analyze() on
+     */
+    static std::unique_ptr<AdvancedAI> createAnalysisAI(bool isWhite, int lines, int timeLimit = 5000);
+    
     /**
      * @brief Get description of AI features for each difficulty level
      * 
@@ -0,0 +1,26 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+#include <cstdint>
+#include <string>
+#include "chessboard.h"
+
+// evaluators for endings the general evaluation plays badly, such as mating with few pieces; each is registered under the material key of its signature
+class Endgames {
+    public:
+        // scores a position from white's point of view; strongIsWhite tells which side has the extra material
+        typedef int (*Evaluator)(const ChessBoard& board, bool strongIsWhite);
+
+        static const int KNOWN_WIN = 2000; // lifts won endings above any ordinary advantage, while staying clear of mate scores
+
+        // the evaluator registered for a material key, or nullptr; strongIsWhite is set when one is found
+        static Evaluator probe(uint64_t materialKey, bool& strongIsWhite);
+
+        // material key of a signature such as "KBNK": the strong side's pieces, then the weak side's, each led by its king
+        static uint64_t materialKey(const std::string& signature, bool strongIsWhite);
+
+    private:
+        static int evaluateKXK(const ChessBoard& board, bool strongIsWhite); // a major piece against a bare king
+        static int evaluateKBNK(const ChessBoard& board, bool strongIsWhite); // bishop and knight against a bare king
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+#include <cstdint>
+
+// a set of squares, one bit per square; bit (row * 8 + col) is set when the square is in the set, so a1 is bit 0 and h8 is bit 63
+typedef uint64_t Bitboard;
+
+inline int squareIndex(int row, int col) { return row * 8 + col; } // square index of a row/col
+inline Bitboard squareBit(int row, int col) { return 1ULL << (row * 8 + col); } // bitboard containing just one square
+
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); } // number of squares in the set
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); } // lowest square in a non-empty set
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); } // highest square in a non-empty set
+inline int popLsb(Bitboard& b) { int sq = lsb(b); b &= b - 1; return sq; } // removes and returns the lowest square
+
+// index of a piece type in per-type tables (p, n, b, r, q, k), or -1 for an unknown type
+inline int pieceTypeIndex(char pieceType) {
+    switch (pieceType) {
+        case 'p': return 0;
+        case 'n': return 1;
+        case 'b': return 2;
+        case 'r': return 3;
+        case 'q': return 4;
+        case 'k': return 5;
+        default: return -1;
+    }
+}
+
+// precomputed attack sets; sliding attacks stop at (and include) the first occupied square in each direction
+class Bitboards {
+    static Bitboard knightTable[64];
+    static Bitboard kingTable[64];
+    static Bitboard pawnTable[2][64]; // [white = 0, black = 1][square]
+    static Bitboard rayTable[8][64]; // [direction][square], empty-board rays
+    static Bitboard betweenTable[64][64]; // [square][square], squares strictly between two aligned squares
+
+    static Bitboard slidingAttacks(int sq, Bitboard occupied, int firstDirection);
+
+    public:
+        static void init(); // fills the tables, safe to call more than once
+
+        static Bitboard knightAttacks(int sq) { return knightTable[sq]; }
+        static Bitboard kingAttacks(int sq) { return kingTable[sq]; }
+        static Bitboard pawnAttacks(bool isWhite, int sq) { return pawnTable[isWhite ? 0 : 1][sq]; } // squares a pawn on sq attacks
+        static Bitboard rookAttacks(int sq, Bitboard occupied) { return slidingAttacks(sq, occupied, 0); }
+        static Bitboard bishopAttacks(int sq, Bitboard occupied) { return slidingAttacks(sq, occupied, 4); }
+        static Bitboard queenAttacks(int sq, Bitboard occupied) { return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied); }
+        static Bitboard between(int a, int b) { return betweenTable[a][b]; } // empty unless the squares share a line
+};
+
+#endif
@@ -15,6 +15,10 @@
 #include "knight.h"
 #include "pawn.h"
 #include "piece.h"
+#include "bitboard.h"
+#include "zobrist.h"
+#include "psqt.h"
+#include "nnue.h"
 
 class Observer;
 class TextObserver;
@@ -31,6 +35,23 @@ class ChessBoard {
 
     Piece* enPassantPawn; // TODO: MAKE SURE TO UPDATE THIS WHEN A PAWN MOVES TWO SQUARES
 
+    Bitboard pieceBitboards[2][6] = {}; // squares occupied by each piece type, [white = 0, black = 1][p, n, b, r, q, k]
+    Bitboard colourBitboards[2] = {}; // squares occupied by each colour
+
+    uint64_t pieceKey = 0; // Zobrist key of the piece placement and en passant pawn
+    uint64_t pawnKey = 0; // Zobrist key of the pawns alone, for caching pawn structure terms
+    uint64_t materialKey = 0; // Zobrist key of the piece counts, for caching terms that depend only on material
+    int midgameScore = 0; // sum of the pieces' middlegame material and piece-square values, from white's point of view
+    int endgameScore = 0; // the same for the endgame
+    int phase = 0; // sum of the pieces' phase weights, PSQT::MAX_PHASE with all the starting material
+    NNUE::Accumulator accumulator; // the network's first-layer sums for this position, kept up to date while a network is loaded
+    int halfmoveClock = 0; // moves since the last capture or pawn move, for the fifty-move rule
+    std::vector<uint64_t> keyHistory; // keys of the positions since the last capture or pawn move, oldest first
+
+    void addToBitboards(Piece* p); // mark a piece's square as occupied and hash it in
+    void removeFromBitboards(Piece* p); // clear a piece's square and hash it out
+    void relocatePiece(Piece* p, int toRow, int toCol); // move a piece to an empty square
+
     public:
 #ifndef NO_GRAPHICS
         ChessBoard(TextObserver *textDisplay, GraphicalObserver *graphicsDisplay); 
@@ -62,6 +83,24 @@ class ChessBoard {
         int getNumKings(bool isWhite) const; // get number of kings of a colour (to check board setup)
         Piece* getEnPassantPawn() const; // get the opponent's pawn that can be enpassanted 
         void setEnPassantPawn(Piece*); // set the pawn that can be enpassanted next turn
+
+        Bitboard getPieces(bool isWhite, char pieceType) const { return pieceBitboards[isWhite ? 0 : 1][pieceTypeIndex(pieceType)]; } // squares of a colour's pieces of one type
+        Bitboard getPieces(bool isWhite) const { return colourBitboards[isWhite ? 0 : 1]; } // squares of all of a colour's pieces
+        Bitboard getOccupied() const { return colourBitboards[0] | colourBitboards[1]; } // squares of all pieces
+        Bitboard attackersTo(int sq, Bitboard occupied) const; // pieces of both colours attacking a square, with sliders seen through the given occupancy
+
+        uint64_t getKey() const { return pieceKey ^ Zobrist::castling(getCastlingRights()); } // Zobrist key of the position, not including the side to move
+        uint64_t getPawnKey() const { return pawnKey; } // Zobrist key of the pawn placement only
+        uint64_t getMaterialKey() const { return materialKey; } // Zobrist key of how many pieces of each type and colour are on the board
+        int getMidgameScore() const { return midgameScore; } // material and piece-square score for the middlegame, from white's point of view
+        int getEndgameScore() const { return endgameScore; } // material and piece-square score for the endgame, from white's point of view
+        int getPhase() const { return phase; } // game phase from the material on the board, 0 with only kings and pawns
+        const NNUE::Accumulator& getAccumulator() { NNUE::refresh(accumulator, pieceBitboards); return accumulator; } // the network's first-layer sums, rebuilt where they are out of date
+        int getCastlingRights() const; // mask of the CastlingRight values still available
+        int getHalfmoveClock() const { return halfmoveClock; } // moves since the last capture or pawn move
+        bool isRepetition(int times = 1) const; // check if the position occurred at least `times` times before with the same side to move
+        bool hasUpcomingRepetition(bool whiteToMove) const; // check if the side to move has a reversible move back into an earlier position
+        bool isFiftyMoveDraw() const { return halfmoveClock >= 100; } // check if fifty moves per side passed without a capture or pawn move
 };
 
 #endif
@@ -0,0 +1,97 @@
+#ifndef NNUE_H
+#define NNUE_H
+#include <cstdint>
+#include <string>
+#include "bitboard.h"
+
+/*
+ * An efficiently updatable neural network evaluator. Its inputs are HalfKP
+ * features, each non-king piece's square relative to one of the kings, and
+ * only a few change per move, so the first layer's sums (the accumulator) are
+ * kept by each board and updated as pieces are added and removed. The layers
+ * after it are small, quantized to int8 and run with SIMD kernels.
+ *
+ * Layout: two halves of HALF_DIMENSIONS first-layer outputs, white's then
+ * black's perspective, clipped and concatenated, then two hidden layers of
+ * HIDDEN outputs and a single output. Like the rest of the evaluation, the
+ * network scores positions from white's point of view regardless of the side
+ * to move.
+ *
+ * Quantization, for whoever exports weights: first-layer weights and biases
+ * are int16 scaled by ACTIVATION_SCALE, so a clipped activation of 1.0 is
+ * 127; hidden weights are int8 scaled by WEIGHT_SCALE, their biases int32
+ * scaled by ACTIVATION_SCALE * WEIGHT_SCALE; the output is in pawns.
+ *
+ * File format, little endian: a HEADER_SIZE byte header (the MAGIC bytes,
+ * then FILE_VERSION, INPUTS, HALF_DIMENSIONS and HIDDEN as uint32, zero
+ * padded), then first-layer biases int16[HALF_DIMENSIONS] and weights
+ * int16[INPUTS][HALF_DIMENSIONS], hidden layer 1 biases int32[HIDDEN] and
+ * weights int8[HIDDEN][2 * HALF_DIMENSIONS], hidden layer 2 biases
+ * int32[HIDDEN] and weights int8[HIDDEN][HIDDEN], output weights
+ * int8[HIDDEN] and output bias int32.
+ */
+class NNUE {
+    public:
+        static const int INPUTS = 64 * 640; // [king square][own then their p, n, b, r, q][square], per perspective
+        static const int HALF_DIMENSIONS = 256; // first-layer outputs per perspective
+        static const int HIDDEN = 32; // outputs of each hidden layer
+        static const int ACTIVATION_SCALE = 127;
+        static const int WEIGHT_SCALE = 64;
+        static const int HEADER_SIZE = 32;
+        static const uint32_t FILE_VERSION = 1;
+        static constexpr const char* MAGIC = "CNUE";
+
+        // first-layer sums of one board, a half per perspective; a half is only updated while valid, and rebuilt when its king moves
+        struct Accumulator {
+            alignas(32) int16_t values[2][HALF_DIMENSIONS]; // [white = 0, black = 1]
+            bool valid[2] = {false, false};
+            uint32_t generation = 0; // network the sums were built with
+        };
+
+        static bool load(const std::string& path); // maps a network file into memory, replacing the current network; false, keeping it, if the file is missing or malformed
+        static bool isLoaded() { return featureWeights != nullptr; }
+        static uint32_t generation() { return networkGeneration; } // changes with every network loaded, 0 while none is
+        static bool isVectorized() { return affineKernel != affineScalar; } // whether the hidden layers use SSSE3 or AVX2 kernels
+
+        // feature of a non-king piece for one perspective: squares are flipped for black, so both perspectives share the weights
+        static int featureIndex(int perspective, int kingSq, int colour, int type, int sq) {
+            if (perspective == 1) { kingSq ^= 56; sq ^= 56; }
+            return kingSq * 640 + (type * 2 + (colour != perspective)) * 64 + sq;
+        }
+
+        // keep an accumulator in step with a piece being added to or removed from a board, whose piece bitboards are [colour][p, n, b, r, q, k]
+        static void addPiece(Accumulator& accumulator, const Bitboard pieces[2][6], int colour, int type, int sq) {
+            if (isLoaded()) updatePiece(accumulator, pieces, colour, type, sq, true);
+        }
+        static void removePiece(Accumulator& accumulator, const Bitboard pieces[2][6], int colour, int type, int sq) {
+            if (isLoaded()) updatePiece(accumulator, pieces, colour, type, sq, false);
+        }
+
+        // rebuilds the halves that are invalid or were built with another network
+        static void refresh(Accumulator& accumulator, const Bitboard pieces[2][6]) {
+            if (isLoaded() && (accumulator.generation != networkGeneration || !accumulator.valid[0] || !accumulator.valid[1])) rebuild(accumulator, pieces);
+        }
+        static int evaluate(const Accumulator& accumulator); // centipawns from white's point of view, from a refreshed accumulator
+
+    private:
+        static const int16_t* featureBiases;
+        static const int16_t* featureWeights; // nullptr while no network is loaded
+        static const int32_t* hidden1Biases;
+        static const int8_t* hidden1Weights;
+        static const int32_t* hidden2Biases;
+        static const int8_t* hidden2Weights;
+        static const int8_t* outputWeights;
+        static const int32_t* outputBias;
+        static uint32_t networkGeneration;
+
+        static void rebuild(Accumulator& accumulator, const Bitboard pieces[2][6]);
+        static void updatePiece(Accumulator& accumulator, const Bitboard pieces[2][6], int colour, int type, int sq, bool add);
+
+        // out[i] = biases[i] + sum of weights[i][j] * input[j], with inputs a multiple of 32
+        static void affineScalar(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out);
+        static void affineSSSE3(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out);
+        static void affineAVX2(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out);
+        static void (*affineKernel)(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out); // picked on load for the running CPU
+};
+
+#endif
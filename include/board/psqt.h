@@ -0,0 +1,27 @@
+#ifndef PSQT_H
+#define PSQT_H
+#include "bitboard.h"
+
+// material plus piece-square values for the middlegame and the endgame, in centipawns; values are signed from white's point of view, so a board's score is the plain sum over its pieces
+class PSQT {
+    static int midgameValues[12][64]; // [white p, n, b, r, q, k, then black][square]
+    static int endgameValues[12][64];
+    static const int phaseWeights[6]; // [p, n, b, r, q, k]
+
+    public:
+        static const int MAX_PHASE = 24; // phase of the starting material, a full middlegame
+
+        static void init(); // fills the tables, safe to call more than once
+
+        static int midgame(bool isWhite, char pieceType, int sq) { return midgameValues[pieceTypeIndex(pieceType) + (isWhite ? 0 : 6)][sq]; }
+        static int endgame(bool isWhite, char pieceType, int sq) { return endgameValues[pieceTypeIndex(pieceType) + (isWhite ? 0 : 6)][sq]; }
+        static int phase(char pieceType) { return phaseWeights[pieceTypeIndex(pieceType)]; } // how much a piece moves the game towards the middlegame
+
+        // blends a middlegame and an endgame score by the game phase, capped at MAX_PHASE
+        static int taper(int midgameScore, int endgameScore, int phase) {
+            if (phase > MAX_PHASE) phase = MAX_PHASE;
+            return (midgameScore * phase + endgameScore * (MAX_PHASE - phase)) / MAX_PHASE;
+        }
+};
+
+#endif
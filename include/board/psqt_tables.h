@@ -0,0 +1,144 @@
+#ifndef PSQT_TABLES_H
+#define PSQT_TABLES_H
+
+/*
+ * Material and piece-square values read by PSQT::init. `chess-train texel`
+ * writes this file with tuned values; these are the hand-written ones it
+ * starts from.
+ *
+ * Piece values are in centipawns (p, n, b, r, q, k); the king is never
+ * traded, so it carries no material. Each table is laid out as the board is
+ * seen from white's side, rank 8 in the first row and rank 1 in the last;
+ * black uses the same tables mirrored.
+ */
+
+static const int midgamePieceValues[6] = {100, 320, 330, 500, 900, 0};
+static const int endgamePieceValues[6] = {100, 320, 330, 500, 900, 0};
+
+static const int midgameTables[6][8][8] = {
+    { // pawns - central advancement and promotion
+        {   0,   0,   0,   0,   0,   0,   0,   0 },
+        {  50,  50,  50,  50,  50,  50,  50,  50 },
+        {  10,  10,  20,  30,  30,  20,  10,  10 },
+        {   5,   5,  10,  25,  25,  10,   5,   5 },
+        {   0,   0,   0,  20,  20,   0,   0,   0 },
+        {   5,  -5, -10,   0,   0, -10,  -5,   5 },
+        {   5,  10,  10, -20, -20,  10,  10,   5 },
+        {   0,   0,   0,   0,   0,   0,   0,   0 }
+    },
+    { // knights - central squares
+        { -50, -40, -30, -30, -30, -30, -40, -50 },
+        { -40, -20,   0,   0,   0,   0, -20, -40 },
+        { -30,   0,  10,  15,  15,  10,   0, -30 },
+        { -30,   5,  15,  20,  20,  15,   5, -30 },
+        { -30,   0,  15,  20,  20,  15,   0, -30 },
+        { -30,   5,  10,  15,  15,  10,   5, -30 },
+        { -40, -20,   0,   5,   5,   0, -20, -40 },
+        { -50, -40, -30, -30, -30, -30, -40, -50 }
+    },
+    { // bishops - long diagonals and central squares
+        { -20, -10, -10, -10, -10, -10, -10, -20 },
+        { -10,   0,   0,   0,   0,   0,   0, -10 },
+        { -10,   0,   5,  10,  10,   5,   0, -10 },
+        { -10,   5,   5,  10,  10,   5,   5, -10 },
+        { -10,   0,  10,  10,  10,  10,   0, -10 },
+        { -10,  10,  10,  10,  10,  10,  10, -10 },
+        { -10,   5,   0,   0,   0,   0,   5, -10 },
+        { -20, -10, -10, -10, -10, -10, -10, -20 }
+    },
+    { // rooks - open files and the 7th rank
+        {   0,   0,   0,   0,   0,   0,   0,   0 },
+        {   5,  10,  10,  10,  10,  10,  10,   5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {   0,   0,   0,   5,   5,   0,   0,   0 }
+    },
+    { // queens - central dominance
+        { -20, -10, -10,  -5,  -5, -10, -10, -20 },
+        { -10,   0,   0,   0,   0,   0,   0, -10 },
+        { -10,   0,   5,   5,   5,   5,   0, -10 },
+        {  -5,   0,   5,   5,   5,   5,   0,  -5 },
+        {   0,   0,   5,   5,   5,   5,   0,  -5 },
+        { -10,   5,   5,   5,   5,   5,   0, -10 },
+        { -10,   0,   5,   0,   0,   0,   0, -10 },
+        { -20, -10, -10,  -5,  -5, -10, -10, -20 }
+    },
+    { // kings - safety behind pawns
+        { -30, -40, -40, -50, -50, -40, -40, -30 },
+        { -30, -40, -40, -50, -50, -40, -40, -30 },
+        { -30, -40, -40, -50, -50, -40, -40, -30 },
+        { -30, -40, -40, -50, -50, -40, -40, -30 },
+        { -20, -30, -30, -40, -40, -30, -30, -20 },
+        { -10, -20, -20, -20, -20, -20, -20, -10 },
+        {  20,  20,   0,   0,   0,   0,  20,  20 },
+        {  20,  30,  10,   0,   0,  10,  30,  20 }
+    }
+};
+
+static const int endgameTables[6][8][8] = {
+    { // pawns - advanced pawns are close to promoting
+        {   0,   0,   0,   0,   0,   0,   0,   0 },
+        {  80,  80,  80,  80,  80,  80,  80,  80 },
+        {  50,  50,  50,  50,  50,  50,  50,  50 },
+        {  30,  30,  30,  30,  30,  30,  30,  30 },
+        {  15,  15,  15,  15,  15,  15,  15,  15 },
+        {   5,   5,   5,   5,   5,   5,   5,   5 },
+        {   0,   0,   0,   0,   0,   0,   0,   0 },
+        {   0,   0,   0,   0,   0,   0,   0,   0 }
+    },
+    { // knights
+        { -50, -40, -30, -30, -30, -30, -40, -50 },
+        { -40, -20,   0,   0,   0,   0, -20, -40 },
+        { -30,   0,  10,  15,  15,  10,   0, -30 },
+        { -30,   5,  15,  20,  20,  15,   5, -30 },
+        { -30,   0,  15,  20,  20,  15,   0, -30 },
+        { -30,   5,  10,  15,  15,  10,   5, -30 },
+        { -40, -20,   0,   5,   5,   0, -20, -40 },
+        { -50, -40, -30, -30, -30, -30, -40, -50 }
+    },
+    { // bishops
+        { -20, -10, -10, -10, -10, -10, -10, -20 },
+        { -10,   0,   0,   0,   0,   0,   0, -10 },
+        { -10,   0,   5,  10,  10,   5,   0, -10 },
+        { -10,   5,   5,  10,  10,   5,   5, -10 },
+        { -10,   0,  10,  10,  10,  10,   0, -10 },
+        { -10,  10,  10,  10,  10,  10,  10, -10 },
+        { -10,   5,   0,   0,   0,   0,   5, -10 },
+        { -20, -10, -10, -10, -10, -10, -10, -20 }
+    },
+    { // rooks
+        {   0,   0,   0,   0,   0,   0,   0,   0 },
+        {   5,  10,  10,  10,  10,  10,  10,   5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {  -5,   0,   0,   0,   0,   0,   0,  -5 },
+        {   0,   0,   0,   5,   5,   0,   0,   0 }
+    },
+    { // queens
+        { -20, -10, -10,  -5,  -5, -10, -10, -20 },
+        { -10,   0,   0,   0,   0,   0,   0, -10 },
+        { -10,   0,   5,   5,   5,   5,   0, -10 },
+        {  -5,   0,   5,   5,   5,   5,   0,  -5 },
+        {   0,   0,   5,   5,   5,   5,   0,  -5 },
+        { -10,   5,   5,   5,   5,   5,   0, -10 },
+        { -10,   0,   5,   0,   0,   0,   0, -10 },
+        { -20, -10, -10,  -5,  -5, -10, -10, -20 }
+    },
+    { // kings - centralization
+        { -50, -40, -30, -20, -20, -30, -40, -50 },
+        { -30, -20, -10,   0,   0, -10, -20, -30 },
+        { -30, -10,  20,  30,  30,  20, -10, -30 },
+        { -30, -10,  30,  40,  40,  30, -10, -30 },
+        { -30, -10,  30,  40,  40,  30, -10, -30 },
+        { -30, -10,  20,  30,  30,  20, -10, -30 },
+        { -30, -30,   0,   0,   0,   0, -30, -30 },
+        { -50, -30, -30, -30, -30, -30, -30, -50 }
+    }
+};
+
+#endif
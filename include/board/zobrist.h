@@ -0,0 +1,37 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+#include <cstdint>
+#include "bitboard.h"
+
+// castling rights as bits of a mask, as used by Zobrist::castling
+enum CastlingRight { WHITE_KINGSIDE = 1, WHITE_QUEENSIDE = 2, BLACK_KINGSIDE = 4, BLACK_QUEENSIDE = 8 };
+
+// random keys for hashing positions; a position's key is the XOR of the keys of its features, so a feature is added or removed by XORing its key again
+class Zobrist {
+    static uint64_t pieceKeys[12][64]; // [white p, n, b, r, q, k, then black][square]
+    static uint64_t blackToMoveKey;
+    static uint64_t castlingKeys[16]; // [mask of castling rights]
+    static uint64_t enPassantKeys[8]; // [file of the pawn that can be captured en passant]
+
+    // cuckoo hash table of every reversible piece move on an empty board, keyed by the XOR of the piece's keys on both squares
+    static const int CUCKOO_SIZE = 8192;
+    static uint64_t cuckooKeys[CUCKOO_SIZE];
+    static uint16_t cuckooMoves[CUCKOO_SIZE]; // the move's two squares, packed as sq1 | sq2 << 6
+
+    static int cuckooSlot1(uint64_t key) { return key & (CUCKOO_SIZE - 1); }
+    static int cuckooSlot2(uint64_t key) { return (key >> 16) & (CUCKOO_SIZE - 1); }
+    static void initCuckoo();
+
+    public:
+        static void init(); // fills the keys from a fixed seed, so keys are identical from run to run
+
+        static uint64_t piece(bool isWhite, char pieceType, int sq) { return pieceKeys[pieceTypeIndex(pieceType) + (isWhite ? 0 : 6)][sq]; }
+        static uint64_t blackToMove() { return blackToMoveKey; }
+        static uint64_t castling(int rights) { return castlingKeys[rights]; }
+        static uint64_t enPassant(int col) { return enPassantKeys[col]; }
+
+        // finds the reversible move (between sq1 and sq2, in either direction) that changes a key by keyDifference
+        static bool findReversibleMove(uint64_t keyDifference, int& sq1, int& sq2);
+};
+
+#endif
@@ -16,6 +16,9 @@ class Player {
     public:
         Player(bool isWhite); 
         virtual bool makeMove(ChessBoard& board) = 0; // generates move from player
+        virtual void updateClock(int /*timeLeftMs*/, int /*incrementMs*/, int /*movesToGo*/) {} // remaining game time before a move (movesToGo is 0 for sudden death)
+        virtual void setPondering(bool /*enable*/) {} // allow thinking on the opponent's time
+        virtual void gameOver() {} // the game has ended, stop any thinking on the opponent's time
         virtual ~Player() = default;
 
 };
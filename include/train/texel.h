@@ -0,0 +1,62 @@
+#ifndef TEXEL_H
+#define TEXEL_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "training_data.h"
+
+/*
+ * Tunes the material and piece-square values of PSQT against game results
+ * (Texel's method) and writes them as a psqt_tables.h the engine builds with.
+ *
+ * A position's score is the tapered sum of its pieces' values, mapped to an
+ * expected result with a sigmoid whose scale is fitted to the data first; the
+ * values are then moved by Adam to minimise the mean squared difference to
+ * the results. Only quiet positions are used, where no capture is pending and
+ * the static score means what it says. Their pieces are cached once as sparse
+ * lists of table entries, so each pass is a few lookups per piece, split
+ * across threads by positions.
+ */
+class TexelTuner {
+    public:
+        struct Options {
+            int iterations = 1000; // full passes over the positions
+            int threads = 1;
+            float learningRate = 1.0f; // centipawns per step, roughly
+            long minimumCount = 1000; // entries in fewer positions than this are left as they are, as Adam would move them as far on little evidence
+        };
+
+        explicit TexelTuner(const Options& options);
+
+        static bool isQuiet(const PackedPosition& position); // no king in check and no piece attacked by a cheaper one or left hanging
+
+        size_t load(const std::vector<PackedPosition>& positions); // caches the quiet positions, returns how many were kept
+        double fitScale(); // picks the sigmoid scale that best fits the current values, returns the error there
+        double error() const; // mean squared error of the cached positions
+        void tune(); // prints the error and the evaluation rate as it goes
+        bool exportTables(const std::string& path) const;
+
+    private:
+        static const int PARAMETERS = 6 * 64; // per phase, [type][square from white's side, a1 = 0]
+
+        // a cached position: each piece is an entry index + 1, negated for black pieces, whose squares are mirrored
+        struct Sample {
+            int16_t pieces[32];
+            uint8_t count;
+            uint8_t phase; // midgame weight out of PSQT::MAX_PHASE
+            float result; // 1, 0.5 or 0 for white
+        };
+
+        Options options;
+        double scale; // centipawns per unit of the sigmoid's input
+        std::vector<double> midgame, endgame; // material plus piece-square value of each entry, in centipawns
+        std::vector<long> occurrences; // positions each entry appears in
+        std::vector<Sample> samples;
+
+        bool isTuned(int entry) const { return occurrences[entry] >= options.minimumCount; }
+        double evaluate(const Sample& sample) const;
+        double errorSum(size_t begin, size_t end, std::vector<double>* midgameGradient, std::vector<double>* endgameGradient) const; // over samples [begin, end), adding each entry's gradient when asked
+        double parallelError(std::vector<double>* midgameGradient, std::vector<double>* endgameGradient) const;
+};
+
+#endif
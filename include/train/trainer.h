@@ -0,0 +1,108 @@
+#ifndef TRAINER_H
+#define TRAINER_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "nnue.h"
+#include "training_data.h"
+
+/*
+ * Trains the engine's network (see NNUE) in floating point on the CPU and
+ * exports it quantized, in the file format NNUE::load reads.
+ *
+ * Each position is scored by the network in pawns and mapped to a win
+ * probability with a sigmoid; the loss is the squared distance to a target
+ * that blends the position's score, through the same sigmoid, with the game's
+ * result. Weights are updated with Adam over minibatches. The first layer's
+ * inputs are sparse, so only the rows of features present in a batch are
+ * touched, and its update is split across threads by columns; the small layers
+ * after it are split by positions, with per-thread gradients summed after.
+ */
+class Trainer {
+    public:
+        struct Options {
+            int epochs = 10;
+            int threads = 1;
+            int batchSize = 16384;
+            float learningRate = 0.001f;
+            float lambda = 0.75f; // weight of the score in the target, the rest is the result
+            float scoreScale = 400.0f; // centipawns per unit of the sigmoid's input
+            double validationFraction = 0.01; // positions held out to measure the loss on
+            uint64_t seed = 1;
+        };
+
+        explicit Trainer(const Options& options);
+
+        void train(std::vector<PackedPosition> positions); // prints the training and validation loss and the throughput after each epoch
+        double loss(const std::vector<PackedPosition>& positions) const; // mean loss over a set of positions
+        bool exportNetwork(const std::string& path) const;
+
+    private:
+        static const int INPUTS = NNUE::INPUTS;
+        static const int HALF = NNUE::HALF_DIMENSIONS;
+        static const int HIDDEN = NNUE::HIDDEN;
+        static const int MAX_FEATURES = 32; // per perspective; a position has at most 30 non-king pieces
+
+        // weights of one layer, with their gradient and Adam's moment estimates
+        struct Parameters {
+            std::vector<float> values, gradient, m, v;
+            explicit Parameters(size_t size) : values(size), gradient(size), m(size), v(size) {}
+        };
+
+        // active features of a position, per perspective
+        struct Features {
+            int index[2][MAX_FEATURES];
+            int count[2];
+        };
+
+        // a position's values at each layer, kept for the backward pass
+        struct Activations {
+            alignas(32) float accumulator[2 * HALF]; // first-layer sums, white's perspective then black's
+            alignas(32) float input[2 * HALF]; // the same, clipped
+            alignas(32) float hidden1Sum[HIDDEN];
+            alignas(32) float hidden1[HIDDEN];
+            alignas(32) float hidden2Sum[HIDDEN];
+            alignas(32) float hidden2[HIDDEN];
+            float output; // pawns, from white's point of view
+        };
+
+        // gradients of the dense parameters, summed by each thread over its share of a batch
+        struct DenseGradients {
+            std::vector<float> featureBiases, hidden1Weights, hidden1Biases, hidden2Weights, hidden2Biases, outputWeights, outputBias;
+            double loss;
+            DenseGradients();
+            void clear();
+        };
+
+        Options options;
+        Parameters featureWeights; // [INPUTS][HALF]
+        Parameters featureBiases; // [HALF]
+        Parameters hidden1Weights; // [HIDDEN][2 * HALF]
+        Parameters hidden1Biases;
+        Parameters hidden2Weights; // [HIDDEN][HIDDEN]
+        Parameters hidden2Biases;
+        Parameters outputWeights; // [HIDDEN]
+        Parameters outputBias; // [1]
+        int step; // Adam updates so far
+
+        // scratch space of the current batch
+        std::vector<Features> batchFeatures;
+        std::vector<float> accumulatorGradients; // [position][2 * HALF], the loss's gradient with respect to the first-layer sums
+        std::vector<DenseGradients> threadGradients;
+        std::vector<int> touchedFeatures; // features present in the batch
+        std::vector<bool> featureTouched; // [INPUTS]
+
+        static void extractFeatures(const PackedPosition& position, Features& features);
+        float target(const PackedPosition& position) const;
+        void forward(const Features& features, Activations& activations) const;
+
+        // forward and backward pass over positions [begin, end) of a batch, leaving each one's first-layer gradient in accumulatorGradients
+        void backpropagate(const std::vector<PackedPosition>& batch, const std::vector<Features>& features, size_t begin, size_t end,
+                           DenseGradients& gradients, std::vector<float>& accumulatorGradients) const;
+        double trainBatch(const std::vector<PackedPosition>& batch); // returns the summed loss before the update
+
+        // applies and clears the scaled gradients of parameters [begin, end), keeping weights within +-limit so they survive quantization
+        void adamUpdate(Parameters& parameters, size_t begin, size_t end, float gradientScale, float limit);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef TRAINING_DATA_H
+#define TRAINING_DATA_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Training positions, packed to 32 bytes each so large sets fit in memory and
+ * load with a single read. A packed file is the raw array, little endian.
+ *
+ * Text files, one position per line, are packed by readTextPositions:
+ *     <FEN> | <score> | <result>
+ * with the score in centipawns and the result 1, 0.5 or 0, both from white's
+ * point of view like the engine's evaluation. EPD lines that carry only a
+ * result, quoted ("1-0", "1/2-1/2", "0-1") or bracketed ([1.0], [0.5], [0.0]),
+ * are read too, with a score of 0. Only the piece placement of the FEN is used.
+ */
+struct PackedPosition {
+    uint64_t occupied; // squares holding a piece, a1 = bit 0
+    uint8_t pieces[16]; // a 4-bit code per piece on those squares from a1 upwards, low nibble first: colour * 6 + type, [white = 0, black = 1][p, n, b, r, q, k]
+    int16_t score; // centipawns, from white's point of view
+    uint8_t result; // 2 if white won, 1 for a draw, 0 if black won
+    uint8_t padding[5];
+
+    // the piece on the index-th occupied square, as colour * 6 + type
+    int piece(int index) const { return (pieces[index / 2] >> (index % 2 * 4)) & 0xF; }
+    void setPiece(int index, int code) { pieces[index / 2] |= code << (index % 2 * 4); }
+};
+static_assert(sizeof(PackedPosition) == 32, "packed positions are 32 bytes");
+
+// packs a FEN's piece placement with a score and result; false if the placement is malformed, lacks a king or has more than 32 pieces
+bool packPosition(const std::string& fen, int score, double result, PackedPosition& position);
+
+// reads "<FEN> | <score> | <result>" or EPD lines, skipping malformed ones; returns how many were skipped, or -1 if the file can't be read
+long readTextPositions(const std::string& path, std::vector<PackedPosition>& positions);
+
+bool readPackedPositions(const std::string& path, std::vector<PackedPosition>& positions); // appends a packed file's positions
+bool writePackedPositions(const std::string& path, const std::vector<PackedPosition>& positions);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SPSA_H
+#define SPSA_H
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "advanced_ai.h"
+
+/*
+ * Tunes AdvancedAI's search parameters (see AdvancedAI::getParameters) by
+ * simultaneous perturbation stochastic approximation: each iteration shifts
+ * every parameter up or down at random at once, plays engines with the
+ * raised and lowered values against each other, and moves the values
+ * towards whichever side scored better. Step sizes shrink over the run as
+ * in Spall's schedule, with per-parameter end values set from its range.
+ *
+ * Games are short, node-limited and played in pairs from the same random
+ * opening with colours swapped, so the opening's bias cancels. The pairs of
+ * an iteration run in parallel on all threads; each thread keeps its two
+ * engines for the whole run and only clears their tables between games, and
+ * games whose outcome is clear from both engines' scores are adjudicated
+ * rather than played out. Node limits keep the games the same however loaded
+ * the machine is, and every opening comes from a seed of its own, so a run
+ * is reproducible whatever the thread count.
+ */
+class SPSATuner {
+    public:
+        struct Options {
+            int iterations = 1000;
+            int threads = 1;
+            int pairsPerIteration = 8; // game pairs played for each update
+            uint64_t nodesPerMove = 5000;
+            int openingPlies = 8; // random moves played before the engines take over
+            int maxPlies = 300; // longer games are drawn
+            double perturbation = 0.05; // final shift of each parameter as a fraction of its range
+            double learningRate = 0.002; // Spall's r at the end of the run
+            uint64_t seed = 1;
+        };
+
+        SPSATuner(const Options& options, const std::vector<AdvancedAI::Parameter>& parameters);
+
+        void tune(); // prints the values, the score and the game rate after each iteration
+        std::vector<AdvancedAI::Parameter> result() const; // current values, rounded
+
+    private:
+        struct Tuned {
+            AdvancedAI::Parameter parameter;
+            double value;
+            double c, a; // Spall's perturbation and step gains
+        };
+
+        struct OpeningMove {
+            int fromRow, fromCol, toRow, toCol;
+        };
+
+        // the engines one thread plays with, [white = 0, black = 1]
+        struct Engines {
+            std::unique_ptr<AdvancedAI> engine[2];
+        };
+
+        Options options;
+        std::vector<Tuned> tuned;
+        std::vector<Engines> threadEngines;
+        double stabilityConstant; // Spall's A
+
+        static void setupStartPosition(ChessBoard& board);
+        std::vector<OpeningMove> randomOpening(std::mt19937_64& random) const;
+        void configure(AdvancedAI& engine, const std::vector<int>& values) const;
+        double playGame(Engines& engines, const std::vector<OpeningMove>& opening) const; // result for white: 1, 0.5 or 0
+};
+
+#endif
@@ -2,177 +2,76 @@
 #include "chessboard.h"
 #include "piece.h"
 #include <algorithm>
-#include <random>
 #include <iostream>
 #include <cassert>
+#include <system_error>
 
 using namespace std;
 
 // Static member initialization
-uint64_t AdvancedAI::zobristTable[8][8][12];
-uint64_t AdvancedAI::zobristBlackToMove;
-uint64_t AdvancedAI::zobristCastling[4];
-uint64_t AdvancedAI::zobristEnPassant[8];
-bool AdvancedAI::zobristInitialized = false;
+// Piece values in centipawns (P, N, B, R, Q, K) used for exchanges and move ordering
+const int AdvancedAI::PIECE_VALUES[6] = {100, 320, 330, 500, 900, 20000};
 
-/**
- * PIECE-SQUARE TABLES
- * 
- * These tables provide positional bonuses/penalties for pieces on different squares.
- * Based on decades of chess knowledge and modern engine tuning.
- * Values are from white's perspective (flip for black).
- */
-
-// Pawn table - encourages central advancement and pawn promotion
-const int AdvancedAI::PAWN_TABLE[8][8] = {
-    {  0,  0,  0,  0,  0,  0,  0,  0 },
-    { 50, 50, 50, 50, 50, 50, 50, 50 },
-    { 10, 10, 20, 30, 30, 20, 10, 10 },
-    {  5,  5, 10, 25, 25, 10,  5,  5 },
-    {  0,  0,  0, 20, 20,  0,  0,  0 },
-    {  5, -5,-10,  0,  0,-10, -5,  5 },
-    {  5, 10, 10,-20,-20, 10, 10,  5 },
-    {  0,  0,  0,  0,  0,  0,  0,  0 }
-};
-
-// Knight table - prefers central squares
-const int AdvancedAI::KNIGHT_TABLE[8][8] = {
-    {-50,-40,-30,-30,-30,-30,-40,-50 },
-    {-40,-20,  0,  0,  0,  0,-20,-40 },
-    {-30,  0, 10, 15, 15, 10,  0,-30 },
-    {-30,  5, 15, 20, 20, 15,  5,-30 },
-    {-30,  0, 15, 20, 20, 15,  0,-30 },
-    {-30,  5, 10, 15, 15, 10,  5,-30 },
-    {-40,-20,  0,  5,  5,  0,-20,-40 },
-    {-50,-40,-30,-30,-30,-30,-40,-50 }
-};
-
-// Bishop table - long diagonals and central squares
-const int AdvancedAI::BISHOP_TABLE[8][8] = {
-    {-20,-10,-10,-10,-10,-10,-10,-20 },
-    {-10,  0,  0,  0,  0,  0,  0,-10 },
-    {-10,  0,  5, 10, 10,  5,  0,-10 },
-    {-10,  5,  5, 10, 10,  5,  5,-10 },
-    {-10,  0, 10, 10, 10, 10,  0,-10 },
-    {-10, 10, 10, 10, 10, 10, 10,-10 },
-    {-10,  5,  0,  0,  0,  0,  5,-10 },
-    {-20,-10,-10,-10,-10,-10,-10,-20 }
-};
-
-// Rook table - open files and 7th rank
-const int AdvancedAI::ROOK_TABLE[8][8] = {
-    {  0,  0,  0,  0,  0,  0,  0,  0 },
-    {  5, 10, 10, 10, 10, 10, 10,  5 },
-    { -5,  0,  0,  0,  0,  0,  0, -5 },
-    { -5,  0,  0,  0,  0,  0,  0, -5 },
-    { -5,  0,  0,  0,  0,  0,  0, -5 },
-    { -5,  0,  0,  0,  0,  0,  0, -5 },
-    { -5,  0,  0,  0,  0,  0,  0, -5 },
-    {  0,  0,  0,  5,  5,  0,  0,  0 }
-};
-
-// Queen table - central dominance
-const int AdvancedAI::QUEEN_TABLE[8][8] = {
-    {-20,-10,-10, -5, -5,-10,-10,-20 },
-    {-10,  0,  0,  0,  0,  0,  0,-10 },
-    {-10,  0,  5,  5,  5,  5,  0,-10 },
-    { -5,  0,  5,  5,  5,  5,  0, -5 },
-    {  0,  0,  5,  5,  5,  5,  0, -5 },
-    {-10,  5,  5,  5,  5,  5,  0,-10 },
-    {-10,  0,  5,  0,  0,  0,  0,-10 },
-    {-20,-10,-10, -5, -5,-10,-10,-20 }
-};
-
-// King middlegame - safety behind pawns
-const int AdvancedAI::KING_MIDDLEGAME_TABLE[8][8] = {
-    {-30,-40,-40,-50,-50,-40,-40,-30 },
-    {-30,-40,-40,-50,-50,-40,-40,-30 },
-    {-30,-40,-40,-50,-50,-40,-40,-30 },
-    {-30,-40,-40,-50,-50,-40,-40,-30 },
-    {-20,-30,-30,-40,-40,-30,-30,-20 },
-    {-10,-20,-20,-20,-20,-20,-20,-10 },
-    { 20, 20,  0,  0,  0,  0, 20, 20 },
-    { 20, 30, 10,  0,  0, 10, 30, 20 }
-};
-
-// King endgame - centralization
-const int AdvancedAI::KING_ENDGAME_TABLE[8][8] = {
-    {-50,-40,-30,-20,-20,-30,-40,-50 },
-    {-30,-20,-10,  0,  0,-10,-20,-30 },
-    {-30,-10, 20, 30, 30, 20,-10,-30 },
-    {-30,-10, 30, 40, 40, 30,-10,-30 },
-    {-30,-10, 30, 40, 40, 30,-10,-30 },
-    {-30,-10, 20, 30, 30, 20,-10,-30 },
-    {-30,-30,  0,  0,  0,  0,-30,-30 },
-    {-50,-30,-30,-30,-30,-30,-30,-50 }
+const AdvancedAI::ParameterInfo AdvancedAI::TUNABLE_PARAMETERS[] = {
+    {"SingularMinDepth", &AdvancedAI::singularMinDepth, 2, 12},
+    {"SingularMargin", &AdvancedAI::singularMargin, 0, 20},
+    {"IIRMinDepth", &AdvancedAI::iirMinDepth, 2, 12},
+    {"ProbCutMinDepth", &AdvancedAI::probCutMinDepth, 3, 12},
+    {"ProbCutReduction", &AdvancedAI::probCutReduction, 2, 6},
+    {"ProbCutMargin", &AdvancedAI::probCutMargin, 50, 600},
+    {"HistoryBonusScale", &AdvancedAI::historyBonusScale, 4, 128},
 };
 
 AdvancedAI::AdvancedAI(bool isWhite, int difficulty) 
-    : Player(isWhite), maxDepth(difficulty * 2), timeLimit(5000),
+    : Player(isWhite), maxDepth(difficulty * 2), timeLimit(5000), moveTimeLimit(5000),
+      clockTimeLeft(-1), clockIncrement(0), clockMovesToGo(0),
       useIterativeDeepening(true), useTranspositionTable(true),
       useNullMovePruning(true), useQuiescenceSearch(true),
-      usePrincipalVariationSearch(true),
-      nodesSearched(0), transpositionHits(0), alphaBetaCutoffs(0), quiescenceNodes(0) {
-    
-    if (!zobristInitialized) {
-        initializeZobristTable();
-    }
+      usePrincipalVariationSearch(true), useLazyEvaluation(true), useNNUE(true),
+      deterministic(false), verbose(true), nodeLimit(0), multiPV(1), searchStopped(false),
+      usePondering(false), pondering(false), ponderHash(0), lastScore(0),
+      nodesSearched(0), transpositionHits(0), alphaBetaCutoffs(0), quiescenceNodes(0), evalCacheHits(0),
+      evaluations(0), lazyEvaluations(0),
+      pawnTableProbes(0), pawnTableHits(0), evalCacheNetwork(0),
+      previousPVHash(0),
+      singularMinDepth(5), singularMargin(2), iirMinDepth(4), probCutMinDepth(5), probCutReduction(4), probCutMargin(200),
+      historyBonusScale(32) {
     
     // Initialize killer moves and history table
-    for (int i = 0; i < 64; ++i) {
-        killerMoves[i][0] = Move();
-        killerMoves[i][1] = Move();
-    }
-    
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            for (int k = 0; k < 8; ++k) {
-                for (int l = 0; l < 8; ++l) {
-                    historyTable[i][j][k][l] = 0;
-                }
-            }
-        }
-    }
+    resetSearchState();
     
     initializeOpeningBook();
 }
 
-/**
- * ZOBRIST HASHING IMPLEMENTATION
- * 
- * Zobrist hashing is a technique for efficiently encoding chess positions
- * as 64-bit integers. It enables fast position lookup in transposition tables.
- * 
- * The key insight is that XOR operations are reversible:
- * hash ^= piece_hash (add piece)
- * hash ^= piece_hash (remove same piece)
- * 
- * This allows incremental hash updates during move generation.
- */
-void AdvancedAI::initializeZobristTable() {
-    random_device rd;
-    mt19937_64 gen(rd());
-    uniform_int_distribution<uint64_t> dis;
-    
-    // Initialize piece hashes
-    for (int square = 0; square < 64; ++square) {
-        for (int piece = 0; piece < 12; ++piece) {
-            zobristTable[square / 8][square % 8][piece] = dis(gen);
-        }
-    }
-    
-    // Special position features
-    zobristBlackToMove = dis(gen);
-    
-    for (int i = 0; i < 4; ++i) {
-        zobristCastling[i] = dis(gen);
+AdvancedAI::~AdvancedAI() {
+    stopPondering();
+}
+
+vector<AdvancedAI::Parameter> AdvancedAI::getParameters() const {
+    vector<Parameter> parameters;
+    for (const ParameterInfo& info : TUNABLE_PARAMETERS) {
+        parameters.push_back(Parameter{info.name, this->*info.value, info.min, info.max});
     }
-    
-    for (int i = 0; i < 8; ++i) {
-        zobristEnPassant[i] = dis(gen);
+    return parameters;
+}
+
+bool AdvancedAI::setParameter(const string& name, int value) {
+    for (const ParameterInfo& info : TUNABLE_PARAMETERS) {
+        if (name == info.name) {
+            this->*info.value = max(info.min, min(info.max, value));
+            return true;
+        }
     }
-    
-    zobristInitialized = true;
+    return false;
+}
+
+void AdvancedAI::newGame() {
+    stopPondering();
+    resetSearchState();
+    previousPV.clear();
+    previousPVHash = 0;
+    ponderMove = Move();
+    lastScore = 0;
 }
 
 int AdvancedAI::getPieceIndex(char pieceType, bool isWhite) {
@@ -189,26 +88,16 @@ int AdvancedAI::getPieceIndex(char pieceType, bool isWhite) {
     return index + (isWhite ? 0 : 6);
 }
 
-uint64_t AdvancedAI::computeZobristHash(ChessBoard& board) const {
-    uint64_t hash = 0;
-    
-    // Hash all pieces on the board
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            Piece* piece = board.getSquare(row, col);
-            if (piece != nullptr) {
-                int pieceIndex = getPieceIndex(piece->getPieceType(), piece->getIsWhite());
-                if (pieceIndex >= 0) {
-                    hash ^= zobristTable[row][col][pieceIndex];
-                }
-            }
-        }
-    }
-    
-    // Add side to move (simplified - assuming we track this)
-    // In a full implementation, you'd track whose turn it is
-    
-    return hash;
+/**
+ * ZOBRIST HASHING
+ * 
+ * The board keeps a Zobrist key of its pieces, castling rights and en passant
+ * pawn up to date as pieces move (XOR a piece's key in when it lands, XOR it
+ * out when it leaves), so hashing a position is a single lookup. Only the side
+ * to move is added here.
+ */
+uint64_t AdvancedAI::computeZobristHash(ChessBoard& board, bool whiteToMove) const {
+    return whiteToMove ? board.getKey() : board.getKey() ^ Zobrist::blackToMove();
 }
 
 /**
@@ -223,23 +112,28 @@ uint64_t AdvancedAI::computeZobristHash(ChessBoard& board) const {
  * 3. Principal variation from shallow searches guides deeper ones
  */
 bool AdvancedAI::makeMove(ChessBoard& board) {
-    clearStatistics();
-    
-    // Check opening book first
-    Move openingMove = getOpeningMove(board);
-    if (openingMove.fromRow != -1) {
-        if (openingMove.promotion != 'x') {
-            board.movePiece(openingMove.fromRow, openingMove.fromCol, 
-                          openingMove.toRow, openingMove.toCol, openingMove.promotion);
-        } else {
-            board.movePiece(openingMove.fromRow, openingMove.fromCol, 
-                          openingMove.toRow, openingMove.toCol);
+    // A ponder search of this very position becomes this move's search
+    Move bestMove;
+    if (!finishPondering(board, bestMove)) {
+        prepareSearch();
+        
+        // Check opening book first
+        Move openingMove = getOpeningMove(board);
+        if (openingMove.fromRow != -1) {
+            lastScore = 0; // book moves aren't searched
+            if (openingMove.promotion != 'x') {
+                board.movePiece(openingMove.fromRow, openingMove.fromCol, 
+                              openingMove.toRow, openingMove.toCol, openingMove.promotion);
+            } else {
+                board.movePiece(openingMove.fromRow, openingMove.fromCol, 
+                              openingMove.toRow, openingMove.toCol);
+            }
+            return true;
         }
-        return true;
+        
+        bestMove = findBestMove(board);
     }
     
-    Move bestMove = findBestMove(board);
-    
     if (bestMove.fromRow == -1) {
         return false; // No legal moves
     }
@@ -253,59 +147,369 @@ bool AdvancedAI::makeMove(ChessBoard& board) {
                        bestMove.toRow, bestMove.toCol);
     }
     
-    printSearchStatistics();
+    if (verbose) printSearchStatistics();
+    startPondering(board);
     return true;
 }
 
+/**
+ * PONDERING
+ * 
+ * After its own move the engine plays the reply its PV expects on a copy of
+ * the board and searches it on a background thread while the opponent
+ * thinks. The search ignores the clock until the opponent has moved:
+ * 
+ * - Ponder hit: the opponent played the expected reply. The running search
+ *   simply continues, now with this move's time budget counted from when
+ *   pondering started, so the time already spent is credited to it.
+ * - Ponder miss: the search is stopped and a normal search starts. Its
+ *   results stay in the transposition table, so positions it shares with
+ *   the real search are not searched again.
+ */
+void AdvancedAI::startPondering(ChessBoard& board) {
+    if (!usePondering || deterministic || ponderMove.fromRow == -1) return;
+    
+    bool opponentIsWhite = !isWhite;
+    if (!isPseudoLegal(ponderMove, board, opponentIsWhite) || !isLegal(ponderMove, board, opponentIsWhite)) return;
+    
+    ponderBoard = make_unique<ChessBoard>(board);
+    ponderBoard->movePiece(ponderMove.fromRow, ponderMove.fromCol, ponderMove.toRow, ponderMove.toCol, ponderMove.promotion);
+    ponderHash = computeZobristHash(*ponderBoard, isWhite);
+    ponderResult = Move();
+    
+    clearStatistics();
+    ttGeneration++;
+    ageHistory();
+    searchStopped = false;
+    pondering = true;
+    ponderStart = chrono::steady_clock::now();
+    
+    try {
+        ponderThread = thread([this]() { ponderResult = findBestMove(*ponderBoard); });
+    } catch (const system_error&) {
+        pondering = false; // no thread support, e.g. in the web build
+    }
+}
+
+bool AdvancedAI::finishPondering(ChessBoard& board, Move& bestMove) {
+    if (!ponderThread.joinable()) return false;
+    
+    if (computeZobristHash(board, isWhite) != ponderHash) {
+        stopPondering();
+        return false;
+    }
+    
+    // The budget counts from when pondering started, so a long ponder can
+    // leave nothing but the move of the last completed iteration to play
+    moveTimeLimit = allocateMoveTime();
+    pondering = false;
+    ponderThread.join();
+    
+    bestMove = ponderResult;
+    return bestMove.fromRow != -1;
+}
+
+void AdvancedAI::stopPondering() {
+    if (!ponderThread.joinable()) return;
+    searchStopped = true;
+    pondering = false;
+    ponderThread.join();
+}
+
+// Resets the per-move state before a new search
+void AdvancedAI::prepareSearch() {
+    clearStatistics();
+    moveTimeLimit = allocateMoveTime();
+    ponderMove = Move();
+    searchStopped = false;
+    
+    // Every deterministic search starts from the same empty tables, so its
+    // node count doesn't depend on what was searched before
+    if (deterministic) {
+        resetSearchState();
+    } else {
+        ttGeneration++;
+        ageHistory();
+    }
+    
+    // Cached evals from another evaluator would mix two scales of scores
+    uint32_t network = usingNNUE() ? NNUE::generation() : 0;
+    if (network != evalCacheNetwork) {
+        evalCache.assign(EVAL_CACHE_SIZE, EvalEntry());
+        evalCacheNetwork = network;
+    }
+}
+
+// Coordinate notation of a move, e.g. e2e4 or e7e8q
+string AdvancedAI::moveToString(const Move& move) {
+    string result;
+    result += static_cast<char>('a' + move.fromCol);
+    result += static_cast<char>('1' + move.fromRow);
+    result += static_cast<char>('a' + move.toCol);
+    result += static_cast<char>('1' + move.toRow);
+    if (move.promotion != 'x') result += move.promotion;
+    return result;
+}
+
 AdvancedAI::Move AdvancedAI::findBestMove(ChessBoard& board) {
     auto startTime = chrono::steady_clock::now();
-    Move bestMove;
-    int bestScore = isWhite ? INT_MIN : INT_MAX;
     
-    if (useIterativeDeepening) {
-        // ITERATIVE DEEPENING IMPLEMENTATION
-        // Start with shallow searches and gradually deepen
-        for (int depth = 1; depth <= maxDepth; ++depth) {
-            if (isTimeUp(startTime)) break;
-            
-            Move currentBest;
-            int score;
-            
-            if (usePrincipalVariationSearch) {
-                score = principalVariationSearch(board, depth, INT_MIN, INT_MAX, isWhite, startTime);
-            } else {
-                score = minimax(board, depth, INT_MIN, INT_MAX, isWhite, startTime);
+    vector<Move> rootMoves = generateMoves(board, isWhite);
+    if (rootMoves.empty()) {
+        return Move();
+    }
+    orderMoves(rootMoves, board, 0, Move());
+    reusePrincipalVariation(board, rootMoves);
+    Move bestMove = rootMoves[0];
+    vector<Move> pv;
+    
+    // ITERATIVE DEEPENING IMPLEMENTATION
+    // Start with shallow searches and gradually deepen; without iterative
+    // deepening only the final depth is searched
+    int firstDepth = useIterativeDeepening ? 1 : maxDepth;
+    for (int depth = firstDepth; depth <= maxDepth; ++depth) {
+        Move iterationBest;
+        int score = searchRoot(board, depth, rootMoves, iterationBest, startTime);
+        
+        // An interrupted iteration is discarded, the previous depth's move stands
+        if (searchStopped) break;
+        
+        bestMove = iterationBest;
+        lastScore = score;
+        pv = extractPrincipalVariation(board, bestMove, depth);
+        
+        // Search the best move first on the next iteration
+        auto it = find(rootMoves.begin(), rootMoves.end(), bestMove);
+        rotate(rootMoves.begin(), it, it + 1);
+        
+        // Pondering is silent, the opponent may be typing a move
+        if (verbose && !pondering) {
+            cout << "Depth " << depth << " completed, score: " << score 
+                 << ", nodes: " << nodesSearched << ", pv:";
+            for (const Move& move : pv) {
+                cout << " " << moveToString(move);
             }
+            cout << endl;
+        }
+        
+        // The next iteration takes several times longer than this one,
+        // so don't start it when it has no chance of finishing
+        if (!deterministic && !pondering) {
+            auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+            if (elapsed.count() * 2 >= moveTimeLimit) break;
+        }
+    }
+    
+    savePrincipalVariation(board, pv);
+    return bestMove;
+}
+
+/**
+ * MULTI-PV ANALYSIS
+ * 
+ * Each iteration searches the root N times. The first pass finds the best
+ * move as usual; every further pass searches only the root moves not yet
+ * reported at this depth, so its best move is the next best line. All passes
+ * share the transposition table and the ordering statistics, so the later
+ * passes mostly replay positions the earlier ones already searched and cost
+ * far less than independent searches. Found moves are moved to the front in
+ * rank order, so the next iteration starts from the previous ranking.
+ */
+vector<AdvancedAI::AnalysisLine> AdvancedAI::analyze(ChessBoard& board) {
+    stopPondering();
+    prepareSearch();
+    auto startTime = chrono::steady_clock::now();
+    
+    vector<AnalysisLine> lines;
+    vector<Move> rootMoves = generateMoves(board, isWhite);
+    if (rootMoves.empty()) {
+        return lines;
+    }
+    orderMoves(rootMoves, board, 0, Move());
+    size_t lineCount = min(static_cast<size_t>(multiPV), rootMoves.size());
+    
+    int firstDepth = useIterativeDeepening ? 1 : maxDepth;
+    for (int depth = firstDepth; depth <= maxDepth; ++depth) {
+        vector<AnalysisLine> iteration;
+        
+        for (size_t pvIndex = 0; pvIndex < lineCount; ++pvIndex) {
+            vector<Move> remaining(rootMoves.begin() + pvIndex, rootMoves.end());
+            Move lineBest;
+            int score = searchRoot(board, depth, remaining, lineBest, startTime);
+            if (searchStopped) break;
             
-            // Update best move if this depth completed successfully
-            if (!isTimeUp(startTime)) {
-                bestScore = score;
-                // Note: In a full implementation, you'd extract the best move from the search
-                // For now, we'll use the first legal move as a placeholder
-                vector<Move> moves = generateMoves(board);
-                if (!moves.empty()) {
-                    bestMove = moves[0];
-                }
-            }
+            auto it = find(rootMoves.begin() + pvIndex, rootMoves.end(), lineBest);
+            rotate(rootMoves.begin() + pvIndex, it, it + 1);
             
-            cout << "Depth " << depth << " completed, score: " << score 
-                 << ", nodes: " << nodesSearched << endl;
+            int mateIn = 0;
+            if (score > MATE_BOUND) mateIn = (MATE_SCORE - score + 1) / 2;
+            else if (score < -MATE_BOUND) mateIn = -(MATE_SCORE + score + 1) / 2;
+            iteration.push_back(AnalysisLine{depth, score, mateIn, extractPrincipalVariation(board, lineBest, depth)});
         }
-    } else {
-        // Single depth search
+        
+        // An interrupted iteration is discarded, the previous depth's lines stand
+        if (searchStopped) break;
+        lines = iteration;
+        
+        for (size_t i = 0; i < lines.size(); ++i) {
+            cout << "Depth " << depth << " line " << i + 1 << ", score: " << lines[i].score << ", pv:";
+            for (const Move& move : lines[i].pv) {
+                cout << " " << moveToString(move);
+            }
+            cout << endl;
+        }
+        
+        if (!deterministic) {
+            auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime);
+            if (elapsed.count() * 2 >= moveTimeLimit) break;
+        }
+    }
+    
+    return lines;
+}
+
+/**
+ * PRINCIPAL VARIATION
+ * 
+ * The expected line is read back from the transposition table, starting with
+ * the root move, and ends where the table has no move or the line repeats.
+ */
+vector<AdvancedAI::Move> AdvancedAI::extractPrincipalVariation(ChessBoard& board, const Move& firstMove,
+                                                              int maxLength) const {
+    vector<Move> pv;
+    ChessBoard tempBoard = board;
+    bool whiteToMove = isWhite;
+    Move move = firstMove;
+    
+    while (move.fromRow != -1 && static_cast<int>(pv.size()) < maxLength) {
+        pv.push_back(move);
+        tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
+        whiteToMove = !whiteToMove;
+        if (tempBoard.isRepetition()) break;
+        
+        TTEntry* entry = findTTEntry(computeZobristHash(tempBoard, whiteToMove));
+        move = Move();
+        if (entry && entry->bestMove.fromRow != -1 &&
+            isPseudoLegal(entry->bestMove, tempBoard, whiteToMove) &&
+            isLegal(entry->bestMove, tempBoard, whiteToMove)) {
+            move = entry->bestMove;
+        }
+    }
+    
+    return pv;
+}
+
+// Keeps the part of the line that follows the opponent's expected reply
+void AdvancedAI::savePrincipalVariation(ChessBoard& board, const vector<Move>& pv) {
+    previousPV.clear();
+    ponderMove = pv.size() >= 2 ? pv[1] : Move();
+    if (pv.size() < 3) return;
+    
+    ChessBoard tempBoard = board;
+    for (int i = 0; i < 2; ++i) {
+        tempBoard.movePiece(pv[i].fromRow, pv[i].fromCol, pv[i].toRow, pv[i].toCol, pv[i].promotion);
+    }
+    previousPV.assign(pv.begin() + 2, pv.end());
+    previousPVHash = computeZobristHash(tempBoard, isWhite);
+}
+
+/**
+ * PRINCIPAL VARIATION REUSE
+ * 
+ * When the opponent played the reply the previous search expected, that
+ * search already worked out the continuation: its first move is tried first
+ * at the root, and the rest of the line is written back into the table
+ * wherever it was overwritten, so every iteration starts down the old line.
+ * The entries carry no usable depth, so they only guide move ordering.
+ */
+void AdvancedAI::reusePrincipalVariation(ChessBoard& board, vector<Move>& rootMoves) {
+    if (previousPV.empty() || computeZobristHash(board, isWhite) != previousPVHash) return;
+    
+    auto it = find(rootMoves.begin(), rootMoves.end(), previousPV[0]);
+    if (it == rootMoves.end()) return;
+    rotate(rootMoves.begin(), it, it + 1);
+    
+    ChessBoard tempBoard = board;
+    bool whiteToMove = isWhite;
+    for (const Move& move : previousPV) {
+        uint64_t hash = computeZobristHash(tempBoard, whiteToMove);
+        if (!isPseudoLegal(move, tempBoard, whiteToMove) || !isLegal(move, tempBoard, whiteToMove)) break;
+        
+        TTEntry* entry = findTTEntry(hash);
+        if (!entry || entry->bestMove.fromRow == -1) {
+            storeInTranspositionTable(hash, 0, 0, 0, move, NodeType::UPPER_BOUND);
+        }
+        
+        tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
+        whiteToMove = !whiteToMove;
+    }
+}
+
+/**
+ * ROOT SEARCH
+ * 
+ * Searches every root move to the given depth and reports the best one.
+ * Scores are from white's point of view, so white maximizes and black minimizes.
+ */
+int AdvancedAI::searchRoot(ChessBoard& board, int depth, const vector<Move>& rootMoves, Move& bestMove,
+                           chrono::steady_clock::time_point startTime) const {
+    bool maximizing = isWhite;
+    int alpha = INT_MIN;
+    int beta = INT_MAX;
+    int bestScore = maximizing ? INT_MIN : INT_MAX;
+    bestMove = rootMoves[0];
+    rootDepth = depth;
+    
+    for (const Move& move : rootMoves) {
+        Piece* moving = board.getSquare(move.fromRow, move.fromCol);
+        searchStack[0].move = move;
+        searchStack[0].piece = getPieceIndex(moving->getPieceType(), moving->getIsWhite());
+        searchStack[0].capture = isCapture(move, board);
+        searchStack[1].extensions = 0;
+        
+        ChessBoard tempBoard = board;
+        if (move.promotion != 'x') {
+            tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
+        } else {
+            tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+        }
+        
+        int score;
         if (usePrincipalVariationSearch) {
-            bestScore = principalVariationSearch(board, maxDepth, INT_MIN, INT_MAX, isWhite, startTime);
+            score = principalVariationSearch(tempBoard, depth - 1, alpha, beta, !maximizing, 1, startTime);
         } else {
-            bestScore = minimax(board, maxDepth, INT_MIN, INT_MAX, isWhite, startTime);
+            score = minimax(tempBoard, depth - 1, alpha, beta, !maximizing, 1, startTime);
         }
         
-        vector<Move> moves = generateMoves(board);
-        if (!moves.empty()) {
-            bestMove = moves[0];
+        if (searchStopped) break;
+        
+        if (maximizing ? score > bestScore : score < bestScore) {
+            bestScore = score;
+            bestMove = move;
+        }
+        
+        if (maximizing) {
+            alpha = max(alpha, score);
+        } else {
+            beta = min(beta, score);
         }
     }
     
-    return bestMove;
+    return bestScore;
+}
+
+// Mate scores count plies from the root, but a stored position can be reached
+// at any ply, so the table holds them as distance from the position itself
+static int scoreToTT(int score, int ply, int mateBound) {
+    if (score > mateBound) return score + ply;
+    if (score < -mateBound) return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply, int mateBound) {
+    if (score > mateBound) return score - ply;
+    if (score < -mateBound) return score + ply;
+    return score;
 }
 
 /**
@@ -321,125 +525,243 @@ AdvancedAI::Move AdvancedAI::findBestMove(ChessBoard& board) {
  * This can reduce the search tree from O(b^d) to O(b^(d/2)) in best case.
  */
 int AdvancedAI::minimax(ChessBoard& board, int depth, int alpha, int beta, 
-                       bool maximizing, chrono::steady_clock::time_point startTime) const {
+                       bool maximizing, int ply, chrono::steady_clock::time_point startTime) const {
     nodesSearched++;
     
-    // Time check
-    if (isTimeUp(startTime)) {
+    // Time or node limit reached - the result is discarded by the root
+    if (shouldStopSearch(startTime) || ply >= MAX_PLY - 1) {
         return evaluatePosition(board);
     }
     
+    // A repeated position is scored as a draw right away: if repeating was
+    // good for either side it can repeat again, so searching on is wasted work
+    if (board.isRepetition() || board.isFiftyMoveDraw() || probeMaterial(board).draw) {
+        return 0;
+    }
+    
+    // Upcoming repetition: if the side to move can step back into an earlier
+    // position it can always settle for the draw, so its bound rises to 0
+    // before any moves are searched
+    if ((maximizing ? alpha < 0 : beta > 0) && board.hasUpcomingRepetition(maximizing)) {
+        if (maximizing) {
+            alpha = 0;
+            if (alpha >= beta) return alpha;
+        } else {
+            beta = 0;
+            if (alpha >= beta) return beta;
+        }
+    }
+    
+    // Mate distance pruning: no line through this node can beat being mated
+    // here or mating on the next ply, so a window outside that range cuts off
+    int matedScore = maximizing ? -MATE_SCORE + ply : MATE_SCORE - ply;
+    int matingScore = maximizing ? MATE_SCORE - ply - 1 : -MATE_SCORE + ply + 1;
+    int lowest = min(matedScore, matingScore);
+    int highest = max(matedScore, matingScore);
+    if (lowest >= beta) return lowest;
+    if (highest <= alpha) return highest;
+    alpha = max(alpha, lowest);
+    beta = min(beta, highest);
+    
     // Base case: leaf node or game over
     if (depth == 0) {
         if (useQuiescenceSearch) {
             return quiescenceSearch(board, alpha, beta, maximizing, startTime);
         } else {
-            return evaluatePosition(board);
+            return evaluatePosition(board, alpha, beta);
         }
     }
     
-    // Transposition table lookup
-    uint64_t hash = computeZobristHash(board);
+    // Transposition table lookup; a singular extension search of this node
+    // leaves out the TT move, so the stored result doesn't apply to it
+    Move excludedMove = searchStack[ply].excludedMove;
+    bool excludedSearch = excludedMove.fromRow != -1;
+    uint64_t hash = computeZobristHash(board, maximizing);
     Move ttMove;
     int ttScore;
-    if (useTranspositionTable && probeTranspositionTable(hash, depth, alpha, beta, ttScore, ttMove)) {
+    if (useTranspositionTable && !excludedSearch &&
+        probeTranspositionTable(hash, depth, ply, alpha, beta, ttScore, ttMove)) {
         transpositionHits++;
         return ttScore;
     }
     
-    vector<Move> moves = generateMoves(board);
-    if (moves.empty()) {
-        // Game over - checkmate or stalemate
-        if (board.checkCheckmate(maximizing)) {
-            return maximizing ? -10000 + depth : 10000 - depth; // Prefer quicker mates
-        } else {
-            return 0; // Stalemate
-        }
-    }
-    
-    // Move ordering for better alpha-beta cutoffs
-    orderMoves(moves, board, depth, ttMove);
+    TTEntry* ttEntry = useTranspositionTable && !excludedSearch ? findTTEntry(hash) : nullptr;
     
-    Move bestMove;
-    NodeType nodeType = NodeType::UPPER_BOUND;
+    // INTERNAL ITERATIVE REDUCTION
+    // Without a TT move the first move searched is only a guess, so a deep
+    // node spends one ply less on it; the next iteration comes back with a
+    // TT move from this shallower search to order by
+    if (!excludedSearch && ttMove.fromRow == -1 && depth >= iirMinDepth) {
+        depth--;
+    }
     
-    if (maximizing) {
-        int maxEval = INT_MIN;
-        for (const Move& move : moves) {
-            if (isTimeUp(startTime)) break;
+    // PROBCUT
+    // A good capture that beats the bound by a wide margin in a much
+    // shallower search will almost certainly beat the bound at full depth,
+    // so the node cuts off on that evidence. The capture is first checked
+    // with a quiescence search and only then verified by the reduced search.
+    int cutBound = maximizing ? beta : alpha;
+    if (!excludedSearch && depth >= probCutMinDepth && abs(cutBound) < MATE_BOUND && !inCheck(board, maximizing)) {
+        int probCutBound = maximizing ? cutBound + probCutMargin : cutBound - probCutMargin;
+        bool ttRefutes = ttEntry && ttEntry->depth >= depth - probCutReduction + 1 &&
+                         (maximizing ? scoreFromTT(ttEntry->score, ply, MATE_BOUND) < probCutBound
+                                     : scoreFromTT(ttEntry->score, ply, MATE_BOUND) > probCutBound);
+        
+        MovePicker captures(maximizing, depth, ply, Move(), true);
+        Move capture;
+        while (!ttRefutes && nextMove(captures, board, capture)) {
+            Piece* moving = board.getSquare(capture.fromRow, capture.fromCol);
+            searchStack[ply].move = capture;
+            searchStack[ply].piece = getPieceIndex(moving->getPieceType(), moving->getIsWhite());
+            searchStack[ply].capture = true;
+            searchStack[ply + 1].extensions = searchStack[ply].extensions;
             
-            // Make move
             ChessBoard tempBoard = board;
-            if (move.promotion != 'x') {
-                tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
-            } else {
-                tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-            }
+            tempBoard.movePiece(capture.fromRow, capture.fromCol, capture.toRow, capture.toCol, capture.promotion);
             
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, false, startTime);
-            
-            if (eval > maxEval) {
-                maxEval = eval;
-                bestMove = move;
+            int lower = maximizing ? probCutBound - 1 : probCutBound;
+            int upper = lower + 1;
+            int value = quiescenceSearch(tempBoard, lower, upper, !maximizing, startTime);
+            bool beatsBound = maximizing ? value >= probCutBound : value <= probCutBound;
+            if (beatsBound) {
+                value = minimax(tempBoard, depth - probCutReduction, lower, upper, !maximizing, ply + 1, startTime);
+                beatsBound = maximizing ? value >= probCutBound : value <= probCutBound;
             }
+            if (searchStopped) return value;
             
-            alpha = max(alpha, eval);
-            if (beta <= alpha) {
-                alphaBetaCutoffs++;
-                updateKillerMoves(move, depth);
-                updateHistoryTable(move, depth);
-                nodeType = NodeType::LOWER_BOUND;
-                break; // Alpha-beta cutoff
+            if (beatsBound) {
+                if (useTranspositionTable) {
+                    storeInTranspositionTable(hash, depth - probCutReduction + 1, ply, value, capture,
+                                              maximizing ? NodeType::LOWER_BOUND : NodeType::UPPER_BOUND);
+                }
+                return value;
             }
         }
+    }
+
+    // The ProbCut searches store into the table and may have replaced this
+    // node's slot with another position, so the entry is looked up again
+    if (ttEntry) ttEntry = findTTEntry(hash);
+
+    // SINGULAR EXTENSION
+    // When the TT move scored well and every other move fails well below
+    // that score in a reduced search, the TT move is the only good move here
+    // and is worth an extra ply
+    bool ttMoveSingular = false;
+    if (ttEntry && ttMove.fromRow != -1 && depth >= singularMinDepth && ttEntry->depth >= depth - 3 &&
+        searchStack[ply].extensions < rootDepth) {
+        int storedScore = scoreFromTT(ttEntry->score, ply, MATE_BOUND);
+        NodeType goodBound = maximizing ? NodeType::LOWER_BOUND : NodeType::UPPER_BOUND;
+        if ((ttEntry->type == goodBound || ttEntry->type == NodeType::EXACT) && abs(storedScore) < MATE_BOUND) {
+            int margin = singularMargin * depth;
+            int singularBound = maximizing ? storedScore - margin : storedScore + margin;
+            
+            searchStack[ply].excludedMove = ttMove;
+            int value = maximizing
+                ? minimax(board, (depth - 1) / 2, singularBound - 1, singularBound, maximizing, ply, startTime)
+                : minimax(board, (depth - 1) / 2, singularBound, singularBound + 1, maximizing, ply, startTime);
+            searchStack[ply].excludedMove = Move();
+            if (searchStopped) return value;
+            
+            ttMoveSingular = maximizing ? value < singularBound : value > singularBound;
+        }
+    }
+    
+    // Moves come from the staged picker, best candidates first
+    MovePicker picker(maximizing, depth, ply, excludedSearch ? Move() : ttMove);
+    Move move;
+    Move bestMove;
+    int bestEval = maximizing ? INT_MIN : INT_MAX;
+    int legalMoves = 0;
+    Move quietsSearched[64]; // quiet moves searched so far, penalized if another quiet move cuts off
+    int quietCount = 0;
+    int originalAlpha = alpha;
+    int originalBeta = beta;
+    
+    while (nextMove(picker, board, move)) {
+        if (move == excludedMove) continue;
         
-        if (useTranspositionTable) {
-            if (alpha > INT_MIN && alpha < INT_MAX) {
-                nodeType = NodeType::EXACT;
-            }
-            storeInTranspositionTable(hash, depth, maxEval, bestMove, nodeType);
+        legalMoves++;
+        bool capture = isCapture(move, board);
+        bool quiet = !capture && move.promotion == 'x';
+        if (quiet && quietCount < 64) {
+            quietsSearched[quietCount++] = move;
         }
         
-        return maxEval;
-    } else {
-        int minEval = INT_MAX;
-        for (const Move& move : moves) {
-            if (isTimeUp(startTime)) break;
-            
-            // Make move
-            ChessBoard tempBoard = board;
-            if (move.promotion != 'x') {
-                tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
-            } else {
-                tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
-            }
-            
-            int eval = minimax(tempBoard, depth - 1, alpha, beta, true, startTime);
-            
-            if (eval < minEval) {
-                minEval = eval;
-                bestMove = move;
+        Piece* moving = board.getSquare(move.fromRow, move.fromCol);
+        searchStack[ply].move = move;
+        searchStack[ply].piece = getPieceIndex(moving->getPieceType(), moving->getIsWhite());
+        searchStack[ply].capture = capture;
+        
+        // Make move
+        ChessBoard tempBoard = board;
+        if (move.promotion != 'x') {
+            tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
+        } else {
+            tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+        }
+        
+        // SEARCH EXTENSIONS
+        // Singular TT moves, checks and recaptures are searched one ply
+        // deeper, so forcing lines are resolved here instead of spilling into
+        // quiescence. Each path may extend by at most the iteration depth.
+        int extension = 0;
+        if (searchStack[ply].extensions < rootDepth) {
+            const PlyInfo& previous = searchStack[ply - 1];
+            bool recapture = capture && previous.capture &&
+                             previous.move.toRow == move.toRow && previous.move.toCol == move.toCol;
+            if ((ttMoveSingular && move == ttMove) || recapture || inCheck(tempBoard, !maximizing)) {
+                extension = 1;
             }
-            
+        }
+        searchStack[ply + 1].extensions = searchStack[ply].extensions + extension;
+        
+        int eval = minimax(tempBoard, depth - 1 + extension, alpha, beta, !maximizing, ply + 1, startTime);
+        if (searchStopped) return eval;
+        
+        if (maximizing ? eval > bestEval : eval < bestEval) {
+            bestEval = eval;
+            bestMove = move;
+        }
+        
+        if (maximizing) {
+            alpha = max(alpha, eval);
+        } else {
             beta = min(beta, eval);
-            if (beta <= alpha) {
-                alphaBetaCutoffs++;
-                updateKillerMoves(move, depth);
-                updateHistoryTable(move, depth);
-                nodeType = NodeType::UPPER_BOUND;
-                break; // Alpha-beta cutoff
-            }
         }
         
-        if (useTranspositionTable) {
-            if (beta > INT_MIN && beta < INT_MAX) {
-                nodeType = NodeType::EXACT;
+        if (beta <= alpha) {
+            alphaBetaCutoffs++;
+            if (quiet) {
+                updateKillerMoves(move, depth);
+                updateQuietHistories(move, quietsSearched, quietCount, board, depth, ply);
             }
-            storeInTranspositionTable(hash, depth, minEval, bestMove, nodeType);
+            break; // Alpha-beta cutoff
+        }
+    }
+    
+    if (legalMoves == 0) {
+        // Only the excluded move is legal: it is singular by definition
+        if (excludedSearch) {
+            return maximizing ? alpha : beta;
         }
         
-        return minEval;
+        // Game over - checkmate or stalemate
+        if (board.checkIfKingIsInCheck(maximizing)) {
+            return maximizing ? -MATE_SCORE + ply : MATE_SCORE - ply; // Prefer quicker mates
+        } else {
+            return 0; // Stalemate
+        }
     }
+    
+    if (useTranspositionTable && !excludedSearch) {
+        NodeType nodeType = bestEval <= originalAlpha ? NodeType::UPPER_BOUND
+                          : bestEval >= originalBeta ? NodeType::LOWER_BOUND
+                          : NodeType::EXACT;
+        storeInTranspositionTable(hash, depth, ply, bestEval, bestMove, nodeType);
+    }
+    
+    return bestEval;
 }
 
 /**
@@ -454,10 +776,10 @@ int AdvancedAI::minimax(ChessBoard& board, int depth, int alpha, int beta,
  * is usually best, so most subsequent searches fail low and are faster.
  */
 int AdvancedAI::principalVariationSearch(ChessBoard& board, int depth, int alpha, int beta,
-                                        bool maximizing, chrono::steady_clock::time_point startTime) const {
+                                        bool maximizing, int ply, chrono::steady_clock::time_point startTime) const {
     // For brevity, this is a simplified version
     // A full PVS implementation would include the null window search logic
-    return minimax(board, depth, alpha, beta, maximizing, startTime);
+    return minimax(board, depth, alpha, beta, maximizing, ply, startTime);
 }
 
 /**
@@ -473,11 +795,11 @@ int AdvancedAI::quiescenceSearch(ChessBoard& board, int alpha, int beta,
                                 bool maximizing, chrono::steady_clock::time_point startTime) const {
     quiescenceNodes++;
     
-    if (isTimeUp(startTime)) {
+    if (shouldStopSearch(startTime)) {
         return evaluatePosition(board);
     }
     
-    int standPat = evaluatePosition(board);
+    int standPat = evaluatePosition(board, alpha, beta);
     
     if (maximizing) {
         if (standPat >= beta) return beta;
@@ -487,13 +809,12 @@ int AdvancedAI::quiescenceSearch(ChessBoard& board, int alpha, int beta,
         beta = min(beta, standPat);
     }
     
-    // Generate only captures and checks
-    vector<Move> captures = generateMoves(board, true);
-    orderMoves(captures, board, 0, Move());
+    // Only good captures: losing captures (negative SEE) can't improve on
+    // the stand-pat score, so the picker prunes them
+    MovePicker picker(maximizing, 0, 0, Move(), true);
+    Move move;
     
-    for (const Move& move : captures) {
-        if (isTimeUp(startTime)) break;
-        
+    while (nextMove(picker, board, move)) {
         ChessBoard tempBoard = board;
         if (move.promotion != 'x') {
             tempBoard.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol, move.promotion);
@@ -502,6 +823,7 @@ int AdvancedAI::quiescenceSearch(ChessBoard& board, int alpha, int beta,
         }
         
         int score = quiescenceSearch(tempBoard, alpha, beta, !maximizing, startTime);
+        if (searchStopped) break;
         
         if (maximizing) {
             alpha = max(alpha, score);
@@ -515,36 +837,429 @@ int AdvancedAI::quiescenceSearch(ChessBoard& board, int alpha, int beta,
     return maximizing ? alpha : beta;
 }
 
-// Move generation - simplified for this implementation
-vector<AdvancedAI::Move> AdvancedAI::generateMoves(ChessBoard& board, bool capturesOnly) const {
-    vector<Move> moves;
+/**
+ * MOVE GENERATION
+ * 
+ * Moves are generated from the board's bitboards in two groups, so the
+ * search can ask for captures without paying for quiet moves:
+ * - captures: captures, en passant and all promotions
+ * - quiets: every other move, including castling
+ * 
+ * Both generators produce pseudo-legal moves; isLegal() then checks that
+ * the move doesn't leave the mover's own king attacked.
+ */
+vector<AdvancedAI::Move> AdvancedAI::generateMoves(ChessBoard& board, bool whiteToMove, bool capturesOnly) const {
+    vector<Move> pseudoLegal;
+    generateCaptureMoves(board, whiteToMove, pseudoLegal);
+    if (!capturesOnly) {
+        generateQuietMoves(board, whiteToMove, pseudoLegal);
+    }
+    
+    vector<Move> moves;
+    for (const Move& move : pseudoLegal) {
+        if (isLegal(move, board, whiteToMove)) {
+            moves.push_back(move);
+        }
+    }
+    
+    return moves;
+}
+
+// Adds a pawn move, expanded into the four promotions on the last rank
+static void addPawnMove(vector<AdvancedAI::Move>& moves, int fromRow, int fromCol, int toRow, int toCol) {
+    if (toRow == 0 || toRow == 7) {
+        moves.emplace_back(fromRow, fromCol, toRow, toCol, 'q');
+        moves.emplace_back(fromRow, fromCol, toRow, toCol, 'r');
+        moves.emplace_back(fromRow, fromCol, toRow, toCol, 'b');
+        moves.emplace_back(fromRow, fromCol, toRow, toCol, 'n');
+    } else {
+        moves.emplace_back(fromRow, fromCol, toRow, toCol);
+    }
+}
+
+// Squares attacked by a non-pawn piece standing on sq
+static Bitboard pieceAttacks(char pieceType, int sq, Bitboard occupied) {
+    switch (pieceType) {
+        case 'n': return Bitboards::knightAttacks(sq);
+        case 'b': return Bitboards::bishopAttacks(sq, occupied);
+        case 'r': return Bitboards::rookAttacks(sq, occupied);
+        case 'q': return Bitboards::queenAttacks(sq, occupied);
+        case 'k': return Bitboards::kingAttacks(sq);
+        default: return 0;
+    }
+}
+
+void AdvancedAI::generateCaptureMoves(ChessBoard& board, bool whiteToMove, vector<Move>& moves) const {
+    Bitboard enemy = board.getPieces(!whiteToMove);
+    Bitboard occupied = board.getOccupied();
+    int forward = whiteToMove ? 1 : -1;
+    int lastRow = whiteToMove ? 7 : 0;
+    Piece* enPassantPawn = board.getEnPassantPawn();
+    
+    Bitboard pawns = board.getPieces(whiteToMove, 'p');
+    while (pawns) {
+        int sq = popLsb(pawns);
+        int row = sq / 8;
+        int col = sq % 8;
+        
+        Bitboard targets = Bitboards::pawnAttacks(whiteToMove, sq) & enemy;
+        while (targets) {
+            int to = popLsb(targets);
+            addPawnMove(moves, row, col, to / 8, to % 8);
+        }
+        
+        // Promotions by pushing count as tactical moves
+        if (row + forward == lastRow && !(occupied & squareBit(lastRow, col))) {
+            addPawnMove(moves, row, col, lastRow, col);
+        }
+        
+        if (enPassantPawn && enPassantPawn->getIsWhite() != whiteToMove &&
+            enPassantPawn->getRow() == row && abs(enPassantPawn->getCol() - col) == 1) {
+            moves.emplace_back(row, col, row + forward, enPassantPawn->getCol());
+        }
+    }
+    
+    for (char pieceType : {'n', 'b', 'r', 'q', 'k'}) {
+        Bitboard pieces = board.getPieces(whiteToMove, pieceType);
+        while (pieces) {
+            int sq = popLsb(pieces);
+            Bitboard targets = pieceAttacks(pieceType, sq, occupied) & enemy;
+            while (targets) {
+                int to = popLsb(targets);
+                moves.emplace_back(sq / 8, sq % 8, to / 8, to % 8);
+            }
+        }
+    }
+}
+
+void AdvancedAI::generateQuietMoves(ChessBoard& board, bool whiteToMove, vector<Move>& moves) const {
+    Bitboard empty = ~board.getOccupied();
+    int forward = whiteToMove ? 1 : -1;
+    int startRow = whiteToMove ? 1 : 6;
+    int lastRow = whiteToMove ? 7 : 0;
+    
+    Bitboard pawns = board.getPieces(whiteToMove, 'p');
+    while (pawns) {
+        int sq = popLsb(pawns);
+        int row = sq / 8;
+        int col = sq % 8;
+        
+        if (row + forward == lastRow || !(empty & squareBit(row + forward, col))) continue;
+        moves.emplace_back(row, col, row + forward, col);
+        
+        if (row == startRow && (empty & squareBit(row + 2 * forward, col))) {
+            moves.emplace_back(row, col, row + 2 * forward, col);
+        }
+    }
+    
+    for (char pieceType : {'n', 'b', 'r', 'q', 'k'}) {
+        Bitboard pieces = board.getPieces(whiteToMove, pieceType);
+        while (pieces) {
+            int sq = popLsb(pieces);
+            Bitboard targets = pieceAttacks(pieceType, sq, ~empty) & empty;
+            while (targets) {
+                int to = popLsb(targets);
+                moves.emplace_back(sq / 8, sq % 8, to / 8, to % 8);
+            }
+        }
+    }
+    
+    int homeRow = whiteToMove ? 0 : 7;
+    if (canCastle(board, whiteToMove, true)) moves.emplace_back(homeRow, 4, homeRow, 6);
+    if (canCastle(board, whiteToMove, false)) moves.emplace_back(homeRow, 4, homeRow, 2);
+}
+
+// Castling rights and empty squares between king and rook; attacked squares are checked by isLegal()
+bool AdvancedAI::canCastle(ChessBoard& board, bool whiteToMove, bool kingside) const {
+    int homeRow = whiteToMove ? 0 : 7;
+    Piece* king = board.getSquare(homeRow, 4);
+    Piece* rook = board.getSquare(homeRow, kingside ? 7 : 0);
+    
+    if (!king || king->getPieceType() != 'k' || king->getIsWhite() != whiteToMove || king->getHasMoved()) return false;
+    if (!rook || rook->getPieceType() != 'r' || rook->getIsWhite() != whiteToMove || rook->getHasMoved()) return false;
+    
+    Bitboard between = kingside ? squareBit(homeRow, 5) | squareBit(homeRow, 6)
+                                : squareBit(homeRow, 1) | squareBit(homeRow, 2) | squareBit(homeRow, 3);
+    return !(board.getOccupied() & between);
+}
+
+// Whether any piece of the given colour attacks a square
+static bool isSquareAttacked(ChessBoard& board, int sq, bool byWhite, Bitboard occupied) {
+    return (board.attackersTo(sq, occupied) & board.getPieces(byWhite)) != 0;
+}
+
+// Whether the given side's king is attacked
+bool AdvancedAI::inCheck(ChessBoard& board, bool white) const {
+    Bitboard kings = board.getPieces(white, 'k');
+    return kings && isSquareAttacked(board, lsb(kings), !white, board.getOccupied());
+}
+
+/**
+ * LEGALITY CHECK
+ * 
+ * A pseudo-legal move is legal when the mover's king isn't attacked once
+ * the move is made. Only the occupancy changes matter for that, so the
+ * move is applied to a copy of the occupancy bitboard instead of the board.
+ */
+bool AdvancedAI::isLegal(const Move& move, ChessBoard& board, bool whiteToMove) const {
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    Bitboard fromBit = squareBit(move.fromRow, move.fromCol);
+    Bitboard toBit = squareBit(move.toRow, move.toCol);
+    Bitboard occupied = board.getOccupied();
+    
+    if (piece->getPieceType() == 'k') {
+        int to = squareIndex(move.toRow, move.toCol);
+        
+        // Castling: not out of, through or into check
+        if (abs(move.toCol - move.fromCol) == 2) {
+            int passing = squareIndex(move.fromRow, (move.fromCol + move.toCol) / 2);
+            return !isSquareAttacked(board, squareIndex(move.fromRow, move.fromCol), !whiteToMove, occupied) &&
+                   !isSquareAttacked(board, passing, !whiteToMove, occupied) &&
+                   !isSquareAttacked(board, to, !whiteToMove, occupied);
+        }
+        
+        Bitboard attackers = board.attackersTo(to, occupied ^ fromBit) & board.getPieces(!whiteToMove) & ~toBit;
+        return attackers == 0;
+    }
+    
+    Bitboard kings = board.getPieces(whiteToMove, 'k');
+    if (!kings) return true;
+    
+    Bitboard captured = toBit;
+    occupied = (occupied ^ fromBit) | toBit;
+    if (piece->getPieceType() == 'p' && move.fromCol != move.toCol && !board.getSquare(move.toRow, move.toCol)) {
+        captured = squareBit(move.fromRow, move.toCol); // en passant
+        occupied ^= captured;
+    }
+    
+    Bitboard attackers = board.attackersTo(lsb(kings), occupied) & board.getPieces(!whiteToMove) & ~captured;
+    return attackers == 0;
+}
+
+/**
+ * PSEUDO-LEGALITY CHECK
+ * 
+ * Validates a move that didn't come from the generators (TT and killer
+ * moves) against the current position without generating any moves.
+ */
+bool AdvancedAI::isPseudoLegal(const Move& move, ChessBoard& board, bool whiteToMove) const {
+    if (move.fromRow < 0 || move.fromRow > 7 || move.fromCol < 0 || move.fromCol > 7 ||
+        move.toRow < 0 || move.toRow > 7 || move.toCol < 0 || move.toCol > 7) {
+        return false;
+    }
+    
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    Piece* target = board.getSquare(move.toRow, move.toCol);
+    if (!piece || piece->getIsWhite() != whiteToMove) return false;
+    if (target && target->getIsWhite() == whiteToMove) return false;
+    
+    char pieceType = piece->getPieceType();
+    bool promotes = pieceType == 'p' && (move.toRow == 0 || move.toRow == 7);
+    if (promotes != (move.promotion != 'x')) return false;
+    if (promotes && move.promotion != 'q' && move.promotion != 'r' && move.promotion != 'b' && move.promotion != 'n') return false;
+    
+    int from = squareIndex(move.fromRow, move.fromCol);
+    Bitboard toBit = squareBit(move.toRow, move.toCol);
+    Bitboard occupied = board.getOccupied();
+    
+    if (pieceType == 'p') {
+        int forward = whiteToMove ? 1 : -1;
+        
+        if (move.fromCol == move.toCol) {
+            if (target) return false;
+            if (move.toRow == move.fromRow + forward) return true;
+            int startRow = whiteToMove ? 1 : 6;
+            return move.fromRow == startRow && move.toRow == move.fromRow + 2 * forward &&
+                   !board.getSquare(move.fromRow + forward, move.fromCol);
+        }
+        
+        if (!(Bitboards::pawnAttacks(whiteToMove, from) & toBit)) return false;
+        if (target) return true;
+        
+        Piece* enPassantPawn = board.getEnPassantPawn();
+        return enPassantPawn && enPassantPawn->getIsWhite() != whiteToMove &&
+               enPassantPawn->getRow() == move.fromRow && enPassantPawn->getCol() == move.toCol;
+    }
+    
+    if (pieceType == 'k' && move.fromRow == move.toRow && abs(move.toCol - move.fromCol) == 2) {
+        return move.fromCol == 4 && move.fromRow == (whiteToMove ? 0 : 7) &&
+               canCastle(board, whiteToMove, move.toCol == 6);
+    }
+    
+    return (pieceAttacks(pieceType, from, occupied) & toBit) != 0;
+}
+
+/**
+ * STAGED MOVE PICKER
+ * 
+ * Most nodes cut off on the TT move or the first good capture, so moves are
+ * produced lazily in stages and later stages are only generated when the
+ * search actually reaches them:
+ * 
+ * 1. TT move, validated against the position without generating moves
+ * 2. Good captures (SEE >= 0), most valuable victim first
+ * 3. Killer moves and the counter move, validated like the TT move
+ * 4. Quiet moves, generated and scored by history only when reached
+ * 5. Bad captures (SEE < 0), deferred from stage 2
+ * 
+ * Within a stage the best remaining move is selected on demand instead of
+ * sorting the whole list. In quiescence only stage 2 is used.
+ */
+AdvancedAI::MovePicker::MovePicker(bool whiteToMove, int depth, int ply, Move ttMove, bool capturesOnly)
+    : stage(PickStage::TT_MOVE), whiteToMove(whiteToMove), capturesOnly(capturesOnly),
+      depth(depth), ply(ply), ttMove(ttMove), index(0) {}
+
+// Moves the highest scored remaining move to position index
+static void pickBest(vector<AdvancedAI::Move>& moves, size_t index) {
+    size_t best = index;
+    for (size_t i = index + 1; i < moves.size(); ++i) {
+        if (moves[i].score > moves[best].score) best = i;
+    }
+    swap(moves[index], moves[best]);
+}
+
+bool AdvancedAI::nextMove(MovePicker& picker, ChessBoard& board, Move& move) const {
+    switch (picker.stage) {
+        case PickStage::TT_MOVE:
+            picker.stage = PickStage::CAPTURES_INIT;
+            if (picker.ttMove.fromRow != -1 && isPseudoLegal(picker.ttMove, board, picker.whiteToMove) &&
+                isLegal(picker.ttMove, board, picker.whiteToMove)) {
+                move = picker.ttMove;
+                return true;
+            }
+            // fall through
+            
+        case PickStage::CAPTURES_INIT:
+            picker.moves.clear();
+            generateCaptureMoves(board, picker.whiteToMove, picker.moves);
+            for (Move& m : picker.moves) {
+                Piece* target = board.getSquare(m.toRow, m.toCol);
+                int victimValue = target ? PIECE_VALUES[pieceTypeIndex(target->getPieceType())] : 0;
+                if (m.promotion != 'x') victimValue += PIECE_VALUES[pieceTypeIndex(m.promotion)];
+                m.score = victimValue * 10 - PIECE_VALUES[pieceTypeIndex(board.getSquare(m.fromRow, m.fromCol)->getPieceType())];
+            }
+            picker.index = 0;
+            picker.stage = PickStage::GOOD_CAPTURES;
+            // fall through
+            
+        case PickStage::GOOD_CAPTURES:
+            while (picker.index < picker.moves.size()) {
+                pickBest(picker.moves, picker.index);
+                Move candidate = picker.moves[picker.index++];
+                if (candidate == picker.ttMove || !isLegal(candidate, board, picker.whiteToMove)) continue;
+                
+                // SEE is only computed for captures that are actually reached
+                if (staticExchangeEvaluation(candidate, board) < 0) {
+                    picker.badCaptures.push_back(candidate);
+                    continue;
+                }
+                
+                move = candidate;
+                return true;
+            }
+            if (picker.capturesOnly) {
+                picker.stage = PickStage::DONE;
+                return false;
+            }
+            picker.index = 0;
+            picker.stage = PickStage::KILLERS;
+            // fall through
+            
+        case PickStage::KILLERS:
+            // Two killers, then the move that last refuted the opponent's previous move
+            while (picker.index < 3) {
+                Move candidate;
+                if (picker.index < 2) {
+                    if (picker.depth < 64) candidate = killerMoves[picker.depth][picker.index];
+                } else if (picker.ply > 0 && searchStack[picker.ply - 1].piece >= 0) {
+                    const PlyInfo& previous = searchStack[picker.ply - 1];
+                    candidate = counterMoves[previous.piece][squareIndex(previous.move.toRow, previous.move.toCol)];
+                    if (isKiller(candidate, picker.depth)) candidate = Move();
+                }
+                picker.index++;
+                
+                if (candidate.fromRow == -1 || candidate == picker.ttMove) continue;
+                if (!isPseudoLegal(candidate, board, picker.whiteToMove) || isCapture(candidate, board) ||
+                    candidate.promotion != 'x' || !isLegal(candidate, board, picker.whiteToMove)) continue;
+                
+                if (picker.index == 3) picker.counterMove = candidate;
+                move = candidate;
+                return true;
+            }
+            picker.stage = PickStage::QUIETS_INIT;
+            // fall through
+            
+        case PickStage::QUIETS_INIT:
+            picker.moves.clear();
+            generateQuietMoves(board, picker.whiteToMove, picker.moves);
+            for (Move& m : picker.moves) {
+                m.score = quietMoveScore(m, board, picker.ply);
+            }
+            picker.index = 0;
+            picker.stage = PickStage::QUIETS;
+            // fall through
+            
+        case PickStage::QUIETS:
+            while (picker.index < picker.moves.size()) {
+                pickBest(picker.moves, picker.index);
+                Move candidate = picker.moves[picker.index++];
+                if (candidate == picker.ttMove || candidate == picker.counterMove ||
+                    isKiller(candidate, picker.depth)) continue;
+                if (!isLegal(candidate, board, picker.whiteToMove)) continue;
+                
+                move = candidate;
+                return true;
+            }
+            picker.index = 0;
+            picker.stage = PickStage::BAD_CAPTURES;
+            // fall through
+            
+        case PickStage::BAD_CAPTURES:
+            if (picker.index < picker.badCaptures.size()) {
+                move = picker.badCaptures[picker.index++];
+                return true;
+            }
+            picker.stage = PickStage::DONE;
+            // fall through
+            
+        case PickStage::DONE:
+            return false;
+    }
+    
+    return false;
+}
+
+bool AdvancedAI::isKiller(const Move& move, int depth) const {
+    return depth < 64 && (move == killerMoves[depth][0] || move == killerMoves[depth][1]);
+}
+
+// Continuation history entry for a move (piece, to) played right after (previousPiece, previousTo)
+static size_t continuationIndex(int previousPiece, int previousTo, int piece, int to) {
+    return ((static_cast<size_t>(previousPiece) * 64 + previousTo) * 12 + piece) * 64 + to;
+}
+
+/**
+ * QUIET MOVE SCORE
+ * 
+ * Butterfly history ([from][to]) plus continuation history for the moves one
+ * and two plies earlier, which captures follow-ups such as answering a
+ * particular attack or continuing a plan.
+ */
+int AdvancedAI::quietMoveScore(const Move& move, ChessBoard& board, int ply) const {
+    int score = historyTable[move.fromRow][move.fromCol][move.toRow][move.toCol];
     
-    for (int fromRow = 0; fromRow < 8; ++fromRow) {
-        for (int fromCol = 0; fromCol < 8; ++fromCol) {
-            Piece* piece = board.getSquare(fromRow, fromCol);
-            if (!piece || piece->getIsWhite() != isWhite) continue;
-            
-            for (int toRow = 0; toRow < 8; ++toRow) {
-                for (int toCol = 0; toCol < 8; ++toCol) {
-                    if (board.verifyMove(fromRow, fromCol, toRow, toCol, isWhite)) {
-                        if (capturesOnly && !board.getSquare(toRow, toCol)) continue;
-                        
-                        // Handle pawn promotion
-                        if (piece->getPieceType() == 'p' && (toRow == 0 || toRow == 7)) {
-                            moves.emplace_back(fromRow, fromCol, toRow, toCol, 'q');
-                            moves.emplace_back(fromRow, fromCol, toRow, toCol, 'r');
-                            moves.emplace_back(fromRow, fromCol, toRow, toCol, 'b');
-                            moves.emplace_back(fromRow, fromCol, toRow, toCol, 'n');
-                        } else {
-                            moves.emplace_back(fromRow, fromCol, toRow, toCol);
-                        }
-                    }
-                }
-            }
-        }
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    int pieceIndex = getPieceIndex(piece->getPieceType(), piece->getIsWhite());
+    int to = squareIndex(move.toRow, move.toCol);
+    
+    for (int back = 1; back <= 2 && ply - back >= 0; ++back) {
+        const PlyInfo& previous = searchStack[ply - back];
+        if (previous.piece < 0) break;
+        int previousTo = squareIndex(previous.move.toRow, previous.move.toCol);
+        score += continuationHistory[continuationIndex(previous.piece, previousTo, pieceIndex, to)];
     }
     
-    return moves;
+    return score;
 }
 
 /**
@@ -554,10 +1269,10 @@ vector<AdvancedAI::Move> AdvancedAI::generateMoves(ChessBoard& board, bool captu
  * We use several heuristics:
  * 
  * 1. Transposition table move (best from previous search)
- * 2. Captures ordered by MVV-LVA (Most Valuable Victim - Least Valuable Attacker)
+ * 2. Winning and equal captures ordered by MVV-LVA (Most Valuable Victim - Least Valuable Attacker)
  * 3. Killer moves (non-captures that caused cutoffs)
  * 4. History heuristic (moves that historically caused cutoffs)
- * 5. Piece-square table values
+ * 5. Losing captures (negative static exchange evaluation), searched last
  */
 void AdvancedAI::orderMoves(vector<Move>& moves, ChessBoard& board, int depth, Move ttMove) const {
     for (Move& move : moves) {
@@ -580,9 +1295,16 @@ int AdvancedAI::scoreMoveForOrdering(const Move& move, ChessBoard& board, int de
     Piece* piece = board.getSquare(move.fromRow, move.fromCol);
     Piece* target = board.getSquare(move.toRow, move.toCol);
     
-    // Captures: MVV-LVA ordering
-    if (target) {
-        score += 10000 + target->getValue() * 10 - piece->getValue();
+    // Captures: MVV-LVA ordering for captures that don't lose material,
+    // losing captures go after all quiet moves
+    if (isCapture(move, board)) {
+        int see = staticExchangeEvaluation(move, board);
+        if (see >= 0) {
+            int victimValue = target ? PIECE_VALUES[pieceTypeIndex(target->getPieceType())] : PIECE_VALUES[0];
+            score += 10000 + victimValue * 10 - PIECE_VALUES[pieceTypeIndex(piece->getPieceType())];
+        } else {
+            score -= 20000 - see;
+        }
     }
     
     // Promotions
@@ -596,9 +1318,143 @@ int AdvancedAI::scoreMoveForOrdering(const Move& move, ChessBoard& board, int de
         else if (move == killerMoves[depth][1]) score += 4000;
     }
     
-    // History heuristic
-    score += historyTable[move.fromRow][move.fromCol][move.toRow][move.toCol];
+    // History heuristic, scaled to stay below the killer bonuses
+    score += historyTable[move.fromRow][move.fromCol][move.toRow][move.toCol] / 8;
+    
+    return score;
+}
+
+/**
+ * STATIC EXCHANGE EVALUATION (SEE)
+ * 
+ * Resolves the sequence of captures on the destination square without
+ * searching it: each side recaptures with its least valuable attacker and
+ * may stop capturing whenever continuing would lose material. Removing each
+ * capturing piece from the occupancy uncovers sliders lined up behind it
+ * (x-rays), so batteries are counted correctly. Pins are ignored.
+ * 
+ * Returns the material balance of the exchange for the side making the move.
+ */
+int AdvancedAI::staticExchangeEvaluation(const Move& move, ChessBoard& board) const {
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    Piece* target = board.getSquare(move.toRow, move.toCol);
+    int to = squareIndex(move.toRow, move.toCol);
+    
+    int gain[32];
+    int d = 0;
+    Bitboard occupied = board.getOccupied() ^ squareBit(move.fromRow, move.fromCol);
+    
+    if (target) {
+        gain[0] = PIECE_VALUES[pieceTypeIndex(target->getPieceType())];
+    } else if (piece->getPieceType() == 'p' && move.fromCol != move.toCol) {
+        gain[0] = PIECE_VALUES[0]; // en passant, the captured pawn is beside the target square
+        occupied ^= squareBit(move.fromRow, move.toCol);
+    } else {
+        gain[0] = 0;
+    }
+    
+    int pieceOnSquare = pieceTypeIndex(piece->getPieceType());
+    if (move.promotion != 'x') {
+        pieceOnSquare = pieceTypeIndex(move.promotion);
+        gain[0] += PIECE_VALUES[pieceOnSquare] - PIECE_VALUES[0];
+    }
+    
+    Bitboard bishopsQueens = board.getPieces(true, 'b') | board.getPieces(false, 'b')
+                           | board.getPieces(true, 'q') | board.getPieces(false, 'q');
+    Bitboard rooksQueens = board.getPieces(true, 'r') | board.getPieces(false, 'r')
+                         | board.getPieces(true, 'q') | board.getPieces(false, 'q');
+    Bitboard attackers = board.attackersTo(to, occupied) & occupied;
+    bool side = !piece->getIsWhite();
+    
+    while (true) {
+        // Speculative gain for the side to capture, assuming it has a recapture
+        d++;
+        gain[d] = PIECE_VALUES[pieceOnSquare] - gain[d - 1];
+        if (max(-gain[d - 1], gain[d]) < 0) break; // pruning doesn't change the sign of the result
+        
+        // Least valuable attacker recaptures
+        Bitboard sideAttackers = attackers & board.getPieces(side);
+        if (!sideAttackers) break;
+        
+        int attackerType = 0;
+        Bitboard attackerBit = 0;
+        for (; attackerType < 6; ++attackerType) {
+            Bitboard candidates = sideAttackers & board.getPieces(side, "pnbrqk"[attackerType]);
+            if (candidates) {
+                attackerBit = candidates & (~candidates + 1);
+                break;
+            }
+        }
+        
+        occupied ^= attackerBit;
+        attackers |= (Bitboards::bishopAttacks(to, occupied) & bishopsQueens)
+                   | (Bitboards::rookAttacks(to, occupied) & rooksQueens);
+        attackers &= occupied;
+        
+        pieceOnSquare = attackerType;
+        side = !side;
+    }
+    
+    // Either side may stand pat instead of recapturing
+    while (--d) {
+        gain[d - 1] = -max(-gain[d - 1], gain[d]);
+    }
+    
+    return gain[0];
+}
+
+bool AdvancedAI::isCapture(const Move& move, ChessBoard& board) const {
+    if (board.getSquare(move.toRow, move.toCol) != nullptr) {
+        return true;
+    }
+    
+    // En passant: a pawn moving diagonally to an empty square
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    return piece && piece->getPieceType() == 'p' && move.fromCol != move.toCol;
+}
+
+/**
+ * EVALUATION CACHE
+ * 
+ * Leaf and quiescence nodes evaluate the same positions over and over, through
+ * transpositions and through the re-searches of iterative deepening. The
+ * static eval only depends on the position, so it is looked up by the board's
+ * key first. The cache is lossy: a slot holds the last position evaluated
+ * there, and the full key is compared so another position never reuses it.
+ * 
+ * LAZY EVALUATION
+ * 
+ * Material and piece-square values are read off the board for free, while
+ * pawns, king safety, mobility and threats cost real work. When the cheap
+ * part is so far outside the alpha-beta window that the other terms, bounded
+ * by LAZY_EVAL_MARGIN, cannot bring it back, the caller only learns that the
+ * score is outside the window either way, so the cheap part is returned as
+ * is. Such partial scores are not cached. Positions whose material scales
+ * the evaluation down are always evaluated in full, as the margin does not
+ * hold for them, and so is everything while the network evaluates.
+ */
+int AdvancedAI::evaluatePosition(ChessBoard& board, int alpha, int beta) const {
+    evaluations++;
+    uint64_t key = board.getKey();
+    EvalEntry& entry = evalCache[key & (EVAL_CACHE_SIZE - 1)];
+    if (entry.key == key) {
+        evalCacheHits++;
+        return entry.score;
+    }
+    
+    const MaterialEntry& material = probeMaterial(board);
+    if (useLazyEvaluation && !usingNNUE() && !material.endgame && material.scaleFactor[0] == MaterialEntry::NORMAL_SCALE &&
+        material.scaleFactor[1] == MaterialEntry::NORMAL_SCALE) {
+        int lazyScore = PSQT::taper(board.getMidgameScore(), board.getEndgameScore(), board.getPhase()) + material.imbalance;
+        if (lazyScore + LAZY_EVAL_MARGIN <= alpha || lazyScore - LAZY_EVAL_MARGIN >= beta) {
+            lazyEvaluations++;
+            return lazyScore;
+        }
+    }
     
+    int score = computeEvaluation(board, material);
+    entry.key = key;
+    entry.score = score;
     return score;
 }
 
@@ -615,126 +1471,432 @@ int AdvancedAI::scoreMoveForOrdering(const Move& move, ChessBoard& board, int de
  * 5. Piece mobility and activity
  * 6. Endgame vs middlegame considerations
  */
-int AdvancedAI::evaluatePosition(ChessBoard& board) const {
-    int score = 0;
+int AdvancedAI::computeEvaluation(ChessBoard& board, const MaterialEntry& material) const {
+    if (material.draw) return 0;
+    if (material.endgame) return material.endgame(board, material.endgameStrongIsWhite);
+    
+    // The network replaces the handcrafted terms; its first layer is kept up
+    // to date by the board as pieces move, so only the small layers run here
+    if (usingNNUE()) {
+        int score = NNUE::evaluate(board.getAccumulator());
+        return score * material.scaleFactor[score > 0 ? 0 : 1] / MaterialEntry::NORMAL_SCALE;
+    }
+    
+    // Material and piece-square values are kept up to date by the board as
+    // pieces move; they are blended by how much material is left, so the king
+    // goes from hiding to centralizing gradually instead of at one threshold
+    int score = PSQT::taper(board.getMidgameScore(), board.getEndgameScore(), board.getPhase());
+    score += material.imbalance;
+    
+    AttackInfo attacks;
+    computeAttacks(board, attacks);
     
-    score += evaluateMaterial(board);
-    score += evaluatePositional(board);
     score += evaluatePawnStructure(board);
-    score += evaluateKingSafety(board);
-    score += evaluateMobility(board);
+    score += evaluateKingSafety(board, attacks);
+    score += evaluateMobility(attacks);
+    score += evaluateThreats(board, attacks);
     
-    return isWhite ? score : -score;
+    // Some material advantages are hard or impossible to win with
+    score = score * material.scaleFactor[score > 0 ? 0 : 1] / MaterialEntry::NORMAL_SCALE;
+    
+    return score; // from white's point of view, like the search
+
 }
 
-int AdvancedAI::evaluateMaterial(ChessBoard& board) const {
-    int score = 0;
-    const int pieceValues[] = {100, 320, 330, 500, 900, 20000}; // P, N, B, R, Q, K
+// Imbalance weights, in centipawns
+static const int BISHOP_PAIR_BONUS = 30;
+static const int KNIGHT_PAWN_ADJUSTMENT = 6; // per knight, for each own pawn above five, less below: knights like closed positions
+static const int ROOK_PAWN_ADJUSTMENT = -12; // per rook, for each own pawn above five, more below: rooks like open files
+
+/**
+ * MATERIAL TABLE
+ * 
+ * Some knowledge depends only on how many pieces of each kind are left, not
+ * on where they stand, and few material combinations turn up in a search.
+ * It is computed once per combination and cached under the material key:
+ * 
+ * - Imbalance: the bishop pair, and knights and rooks gaining or losing
+ *   value with the number of their own pawns
+ * - Scale factors: without pawns, an extra minor piece is rarely enough to
+ *   win, and two knights cannot force mate at all
+ * - Draws: with a lone minor piece at most, neither side can ever mate
+ * - Endgames: basic mates get an evaluator of their own, see Endgames
+ */
+const AdvancedAI::MaterialEntry& AdvancedAI::probeMaterial(const ChessBoard& board) const {
+    uint64_t key = board.getMaterialKey();
+    MaterialEntry& entry = materialTable[key & (MATERIAL_TABLE_SIZE - 1)];
+    if (entry.key != key) {
+        entry = MaterialEntry();
+        entry.key = key;
+        computeMaterial(board, entry);
+    }
+    return entry;
+}
+
+void AdvancedAI::computeMaterial(const ChessBoard& board, MaterialEntry& entry) {
+    int count[2][6];
+    int nonPawnMaterial[2] = {0, 0};
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int type = 0; type < 6; ++type) {
+            count[colour][type] = popCount(board.getPieces(colour == 0, "pnbrqk"[type]));
+            if (type > 0 && type < 5) nonPawnMaterial[colour] += count[colour][type] * PIECE_VALUES[type];
+        }
+    }
     
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            Piece* piece = board.getSquare(row, col);
-            if (!piece) continue;
-            
-            int value = piece->getValue() * 100; // Convert to centipawns
-            score += piece->getIsWhite() ? value : -value;
+    if (count[0][0] + count[1][0] == 0 && nonPawnMaterial[0] + nonPawnMaterial[1] <= PIECE_VALUES[2]) {
+        entry.draw = true;
+        entry.scaleFactor[0] = entry.scaleFactor[1] = 0;
+        return;
+    }
+    
+    entry.endgame = Endgames::probe(board.getMaterialKey(), entry.endgameStrongIsWhite);
+    if (entry.endgame) return;
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        int enemy = 1 - colour;
+        int bonus = 0;
+        if (count[colour][2] >= 2) bonus += BISHOP_PAIR_BONUS;
+        bonus += count[colour][1] * KNIGHT_PAWN_ADJUSTMENT * (count[colour][0] - 5);
+        bonus += count[colour][3] * ROOK_PAWN_ADJUSTMENT * (count[colour][0] - 5);
+        entry.imbalance += colour == 0 ? bonus : -bonus;
+        
+        // Without pawns, being up a minor piece or less is rarely enough: it
+        // is a draw with no more than a minor piece, and hard otherwise
+        if (count[colour][0] == 0) {
+            bool onlyKnights = nonPawnMaterial[colour] == count[colour][1] * PIECE_VALUES[1];
+            if (onlyKnights && count[colour][1] <= 2 && nonPawnMaterial[enemy] == 0 && count[enemy][0] == 0) {
+                entry.scaleFactor[colour] = 0; // two knights cannot force mate
+            } else if (nonPawnMaterial[colour] - nonPawnMaterial[enemy] <= PIECE_VALUES[2]) {
+                entry.scaleFactor[colour] = nonPawnMaterial[colour] < PIECE_VALUES[3] ? 0
+                                          : nonPawnMaterial[enemy] <= PIECE_VALUES[2] ? 4 : 14;
+            }
+        }
+    }
+}
+
+/**
+ * PAWN STRUCTURE
+ * 
+ * Pawns move rarely and never backwards, so the same pawn structure turns up
+ * in nearly every node of a search. Its terms are computed from the pawn
+ * bitboards once and kept in the pawn hash table under the pawn-only key.
+ * The pawn shield also depends on where the king stands, so each entry keeps
+ * the shields of the king squares it was last used with and only recomputes
+ * the shield of a king that has moved.
+ */
+int AdvancedAI::evaluatePawnStructure(ChessBoard& board) const {
+    uint64_t key = board.getPawnKey();
+    PawnEntry& entry = pawnTable[key & (PAWN_TABLE_SIZE - 1)];
+    pawnTableProbes++;
+    if (entry.key == key) {
+        pawnTableHits++;
+    } else {
+        entry = PawnEntry();
+        entry.key = key;
+        entry.score = computePawnStructure(board);
+    }
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        Bitboard king = board.getPieces(colour == 0, 'k');
+        int kingSquare = king ? lsb(king) : 64;
+        if (entry.kingSquare[colour] != kingSquare) {
+            entry.kingSquare[colour] = kingSquare;
+            entry.shield[colour] = king ? computePawnShield(board, colour == 0, kingSquare) : 0;
         }
     }
     
-    return score;
+    return entry.score + entry.shield[0] - entry.shield[1];
+}
+
+// Pawn structure weights, in centipawns
+static const int PASSED_PAWN_BONUS[8] = {0, 5, 10, 20, 35, 60, 100, 0}; // by rank from the pawn's side
+static const int DOUBLED_PAWN_PENALTY = 15;
+static const int ISOLATED_PAWN_PENALTY = 15;
+static const int BACKWARD_PAWN_PENALTY = 10;
+static const int CONNECTED_PAWN_BONUS = 8;
+static const int SHIELD_PAWN_BONUS[2] = {12, 6}; // shield pawn one or two ranks in front of the king
+
+static const Bitboard FILE_A_SQUARES = 0x0101010101010101ULL;
+
+// squares on the files either side of a file
+static Bitboard adjacentFiles(int col) {
+    Bitboard files = 0;
+    if (col > 0) files |= FILE_A_SQUARES << (col - 1);
+    if (col < 7) files |= FILE_A_SQUARES << (col + 1);
+    return files;
+}
+
+// squares on the rows in front of a row, as seen by one side
+static Bitboard rowsAhead(bool isWhite, int row) {
+    if (isWhite) return row >= 7 ? 0 : ~0ULL << (8 * (row + 1));
+    return row <= 0 ? 0 : (1ULL << (8 * row)) - 1;
 }
 
-int AdvancedAI::evaluatePositional(ChessBoard& board) const {
+// Pawn structure score from white's point of view, without the pawn shields
+int AdvancedAI::computePawnStructure(const ChessBoard& board) {
     int score = 0;
-    bool endgame = isEndgame(board);
     
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            Piece* piece = board.getSquare(row, col);
-            if (!piece) continue;
+    for (int colour = 0; colour < 2; ++colour) {
+        bool isWhite = colour == 0;
+        Bitboard ownPawns = board.getPieces(isWhite, 'p');
+        Bitboard enemyPawns = board.getPieces(!isWhite, 'p');
+        int sideScore = 0;
+        
+        for (Bitboard pawns = ownPawns; pawns; ) {
+            int sq = popLsb(pawns);
+            int row = sq / 8, col = sq % 8;
+            Bitboard file = FILE_A_SQUARES << col;
+            Bitboard neighbours = adjacentFiles(col);
+            Bitboard ahead = rowsAhead(isWhite, row);
             
-            int tableValue = 0;
-            int adjustedRow = piece->getIsWhite() ? row : 7 - row;
+            bool doubled = (ownPawns & file & ahead) != 0; // the rear pawn of a doubled pair pays
+            bool isolated = (ownPawns & neighbours) == 0;
+            bool supported = (Bitboards::pawnAttacks(!isWhite, sq) & ownPawns) != 0;
+            bool phalanx = (ownPawns & neighbours & (0xFFULL << (8 * row))) != 0;
             
-            switch (tolower(piece->getPieceType())) {
-                case 'p': tableValue = PAWN_TABLE[adjustedRow][col]; break;
-                case 'n': tableValue = KNIGHT_TABLE[adjustedRow][col]; break;
-                case 'b': tableValue = BISHOP_TABLE[adjustedRow][col]; break;
-                case 'r': tableValue = ROOK_TABLE[adjustedRow][col]; break;
-                case 'q': tableValue = QUEEN_TABLE[adjustedRow][col]; break;
-                case 'k': 
-                    tableValue = endgame ? KING_ENDGAME_TABLE[adjustedRow][col] 
-                                         : KING_MIDDLEGAME_TABLE[adjustedRow][col]; 
-                    break;
+            if (doubled) sideScore -= DOUBLED_PAWN_PENALTY;
+            if (isolated) sideScore -= ISOLATED_PAWN_PENALTY;
+            if (supported || phalanx) sideScore += CONNECTED_PAWN_BONUS;
+            
+            // Passed: no enemy pawn can stop or capture it on its way, and no own pawn blocks it
+            if (!doubled && (enemyPawns & (file | neighbours) & ahead) == 0) {
+                sideScore += PASSED_PAWN_BONUS[isWhite ? row : 7 - row];
             }
             
-            score += piece->getIsWhite() ? tableValue : -tableValue;
+            // Backward: every neighbour has advanced past it, and an enemy pawn guards its stop square
+            int stop = isWhite ? sq + 8 : sq - 8;
+            if (!isolated && !supported && !phalanx && stop >= 0 && stop < 64 &&
+                (ownPawns & neighbours & ~ahead) == 0 &&
+                (Bitboards::pawnAttacks(isWhite, stop) & enemyPawns) != 0) {
+                sideScore -= BACKWARD_PAWN_PENALTY;
+            }
         }
+        
+        score += isWhite ? sideScore : -sideScore;
     }
     
     return score;
 }
 
-int AdvancedAI::evaluatePawnStructure(ChessBoard& board) const {
-    // Simplified pawn structure evaluation
-    // In a full engine, this would check for:
-    // - Passed pawns, doubled pawns, isolated pawns
-    // - Pawn chains and pawn storms
-    // - Weak squares and pawn breaks
-    return 0;
-}
-
-int AdvancedAI::evaluateKingSafety(ChessBoard& board) const {
-    // Simplified king safety evaluation
-    // In a full engine, this would check for:
-    // - Pawn shield in front of king
-    // - Open files near king
-    // - Enemy piece attacks on king zone
-    return 0;
-}
-
-int AdvancedAI::evaluateMobility(ChessBoard& board) const {
-    // Count legal moves for both sides
-    // More mobility generally indicates better position
-    return 0;
-}
-
-bool AdvancedAI::isEndgame(ChessBoard& board) const {
-    int totalMaterial = 0;
-    for (int row = 0; row < 8; ++row) {
-        for (int col = 0; col < 8; ++col) {
-            Piece* piece = board.getSquare(row, col);
-            if (piece && tolower(piece->getPieceType()) != 'k') {
-                totalMaterial += piece->getValue();
+// Bonus for a side's pawns on the king's file and the files beside it, one or two ranks in front of the king
+int AdvancedAI::computePawnShield(const ChessBoard& board, bool isWhite, int kingSquare) {
+    int row = kingSquare / 8, col = kingSquare % 8;
+    Bitboard files = (FILE_A_SQUARES << col) | adjacentFiles(col);
+    Bitboard ownPawns = board.getPieces(isWhite, 'p') & files;
+    int shield = 0;
+    
+    for (int step = 1; step <= 2; ++step) {
+        int shieldRow = isWhite ? row + step : row - step;
+        if (shieldRow < 0 || shieldRow > 7) break;
+        shield += popCount(ownPawns & (0xFFULL << (8 * shieldRow))) * SHIELD_PAWN_BONUS[step - 1];
+    }
+    
+    return shield;
+}
+
+// Mobility: centipawns per square a piece reaches beyond the typical count, by piece type (p, n, b, r, q, k)
+static const int MOBILITY_WEIGHT[6] = {0, 4, 5, 2, 1, 0};
+static const int MOBILITY_BASE[6] = {0, 4, 6, 7, 13, 0};
+
+// King safety: weight of each attack on a square of the king zone, by attacker type,
+// scaled up with the number of attackers since a lone attacker rarely gets through
+static const int KING_ATTACK_WEIGHT[6] = {0, 10, 10, 20, 40, 0};
+static const int KING_ATTACK_SCALE[8] = {0, 0, 50, 75, 88, 94, 97, 99}; // percent, by attacker count
+static const int KING_OPEN_FILE_PENALTY = 20; // per file at the king without a pawn of its own
+
+// Threats
+static const int THREAT_BY_PAWN_PENALTY = 30; // piece attacked by an enemy pawn
+static const int HANGING_PIECE_PENALTY = 25; // piece attacked and not defended
+
+/**
+ * ATTACK MAPS
+ * 
+ * The per-piece terms of the evaluation are gathered in a single pass over
+ * the piece bitboards: attack sets, mobility and attacks on the enemy king
+ * zone. Material and piece-square values need no pass at all, the board keeps
+ * their sums.
+ * 
+ * Mobility, king safety and threats all ask which squares each side attacks.
+ * Legal move generation through verifyMove is far too slow to answer that at
+ * every leaf, so the attack sets come from the attack bitboards instead: one
+ * lookup per piece, with pins and checks ignored.
+ * 
+ * Mobility only counts squares that are not held by the piece's own side or
+ * attacked by an enemy pawn, since moving there is rarely worth anything.
+ * Pawns are scanned first so that the pawn attacks are known for it.
+ */
+void AdvancedAI::computeAttacks(const ChessBoard& board, AttackInfo& attacks) {
+    Bitboard occupied = board.getOccupied();
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        bool isWhite = colour == 0;
+        Bitboard pawnAttacks = 0;
+        for (Bitboard pawns = board.getPieces(isWhite, 'p'); pawns; ) {
+            pawnAttacks |= Bitboards::pawnAttacks(isWhite, popLsb(pawns));
+        }
+        attacks.byType[colour][0] = pawnAttacks;
+        attacks.all[colour] = pawnAttacks;
+        attacks.mobility[colour] = 0;
+        attacks.kingAttackers[1 - colour] = 0;
+        attacks.kingAttackWeight[1 - colour] = 0;
+    }
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        bool isWhite = colour == 0;
+        int enemy = 1 - colour;
+        Bitboard mobilityArea = ~board.getPieces(isWhite) & ~attacks.byType[enemy][0];
+        Bitboard enemyKing = board.getPieces(!isWhite, 'k');
+        Bitboard kingZone = enemyKing ? Bitboards::kingAttacks(lsb(enemyKing)) | enemyKing : 0;
+        
+        for (int type = 1; type < 6; ++type) {
+            attacks.byType[colour][type] = 0;
+            for (Bitboard pieces = board.getPieces(isWhite, "pnbrqk"[type]); pieces; ) {
+                int sq = popLsb(pieces);
+                Bitboard pieceAttacks;
+                switch (type) {
+                    case 1: pieceAttacks = Bitboards::knightAttacks(sq); break;
+                    case 2: pieceAttacks = Bitboards::bishopAttacks(sq, occupied); break;
+                    case 3: pieceAttacks = Bitboards::rookAttacks(sq, occupied); break;
+                    case 4: pieceAttacks = Bitboards::queenAttacks(sq, occupied); break;
+                    default: pieceAttacks = Bitboards::kingAttacks(sq); break;
+                }
+                
+                attacks.all[colour] |= pieceAttacks;
+                attacks.byType[colour][type] |= pieceAttacks;
+                attacks.mobility[colour] += MOBILITY_WEIGHT[type] *
+                                            (popCount(pieceAttacks & mobilityArea) - MOBILITY_BASE[type]);
+                
+                Bitboard zoneAttacks = pieceAttacks & kingZone;
+                if (zoneAttacks && type != 5) {
+                    attacks.kingAttackers[enemy]++;
+                    attacks.kingAttackWeight[enemy] += KING_ATTACK_WEIGHT[type] * popCount(zoneAttacks);
+                }
             }
         }
     }
-    return totalMaterial < 20; // Rough endgame threshold
 }
 
-// Transposition table methods
-void AdvancedAI::storeInTranspositionTable(uint64_t hash, int depth, int score, 
+/**
+ * KING SAFETY
+ * 
+ * A king is in danger when several enemy pieces bear on the squares around
+ * it, and when the files in front of it have lost their pawns. The pawn
+ * shield itself is scored with the pawn structure. Without the enemy queen an
+ * attack rarely gets through, so then the king is left alone.
+ */
+int AdvancedAI::evaluateKingSafety(const ChessBoard& board, const AttackInfo& attacks) {
+    int score = 0;
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        bool isWhite = colour == 0;
+        Bitboard king = board.getPieces(isWhite, 'k');
+        if (!king || !board.getPieces(!isWhite, 'q')) continue;
+        
+        int danger = attacks.kingAttackWeight[colour] * KING_ATTACK_SCALE[min(attacks.kingAttackers[colour], 7)] / 100;
+        
+        int col = lsb(king) % 8;
+        Bitboard ownPawns = board.getPieces(isWhite, 'p');
+        for (int file = max(col - 1, 0); file <= min(col + 1, 7); ++file) {
+            if (!(ownPawns & (FILE_A_SQUARES << file))) danger += KING_OPEN_FILE_PENALTY;
+        }
+        
+        score += isWhite ? -danger : danger;
+    }
+    
+    return score;
+}
+
+int AdvancedAI::evaluateMobility(const AttackInfo& attacks) {
+    return attacks.mobility[0] - attacks.mobility[1];
+}
+
+/**
+ * THREATS
+ * 
+ * Pieces attacked by an enemy pawn, and pieces attacked without a defender,
+ * are likely to lose material soon. Pawns and kings are not counted.
+ */
+int AdvancedAI::evaluateThreats(const ChessBoard& board, const AttackInfo& attacks) {
+    int score = 0;
+    
+    for (int colour = 0; colour < 2; ++colour) {
+        bool isWhite = colour == 0;
+        int enemy = 1 - colour;
+        Bitboard pieces = board.getPieces(isWhite) & ~board.getPieces(isWhite, 'p') & ~board.getPieces(isWhite, 'k');
+        
+        int penalty = THREAT_BY_PAWN_PENALTY * popCount(pieces & attacks.byType[enemy][0])
+                    + HANGING_PIECE_PENALTY * popCount(pieces & attacks.all[enemy] & ~attacks.all[colour]);
+        
+        score += isWhite ? -penalty : penalty;
+    }
+    
+    return score;
+}
+
+/**
+ * TRANSPOSITION TABLE REPLACEMENT
+ * 
+ * The table has a fixed number of slots, grouped in buckets of two. A
+ * position keeps its slot when it is stored again, unless the new result is
+ * a shallower bound from the same search. Otherwise the slot holding less
+ * useful information is replaced: each search the entry is older costs it
+ * the value of several plies of depth, so stale entries from earlier moves
+ * give way before deep results of the current one.
+ */
+void AdvancedAI::storeInTranspositionTable(uint64_t hash, int depth, int ply, int score, 
                                           Move bestMove, NodeType type) const {
-    if (transpositionTable.size() >= MAX_TT_SIZE) {
-        // Simple replacement scheme - in practice, use more sophisticated replacement
-        transpositionTable.clear();
+    TTEntry* bucket = &transpositionTable[hash & (TT_SIZE - 2)];
+    TTEntry* slot = nullptr;
+    
+    if (bucket[0].hash == hash) {
+        slot = &bucket[0];
+    } else if (bucket[1].hash == hash) {
+        slot = &bucket[1];
+    }
+    
+    if (slot) {
+        if (type != NodeType::EXACT && depth < slot->depth && slot->generation == ttGeneration) {
+            return;
+        }
+        if (bestMove.fromRow == -1) {
+            bestMove = slot->bestMove; // keep the move from a previous search of the position
+        }
+    } else {
+        auto worth = [this](const TTEntry& entry) {
+            return entry.depth - 8 * static_cast<uint8_t>(ttGeneration - entry.generation);
+        };
+        slot = worth(bucket[1]) < worth(bucket[0]) ? &bucket[1] : &bucket[0];
     }
     
-    transpositionTable[hash] = TTEntry(hash, depth, score, bestMove, type);
+    *slot = TTEntry(hash, depth, scoreToTT(score, ply, MATE_BOUND), bestMove, type, ttGeneration);
+}
+
+AdvancedAI::TTEntry* AdvancedAI::findTTEntry(uint64_t hash) const {
+    TTEntry* bucket = &transpositionTable[hash & (TT_SIZE - 2)];
+    for (int i = 0; i < 2; ++i) {
+        if (bucket[i].hash == hash && bucket[i].depth >= 0) {
+            bucket[i].generation = ttGeneration; // still useful, so it counts as current
+            return &bucket[i];
+        }
+    }
+    return nullptr;
 }
 
-bool AdvancedAI::probeTranspositionTable(uint64_t hash, int depth, int alpha, int beta,
+bool AdvancedAI::probeTranspositionTable(uint64_t hash, int depth, int ply, int alpha, int beta,
                                         int& score, Move& bestMove) const {
-    auto it = transpositionTable.find(hash);
-    if (it == transpositionTable.end() || it->second.depth < depth) {
+    TTEntry* entry = findTTEntry(hash);
+    if (!entry) {
         return false;
     }
     
-    const TTEntry& entry = it->second;
-    score = entry.score;
-    bestMove = entry.bestMove;
+    // The stored move is worth trying first even when the entry is too shallow for a cutoff
+    bestMove = entry->bestMove;
+    if (entry->depth < depth) {
+        return false;
+    }
+    score = scoreFromTT(entry->score, ply, MATE_BOUND);
     
-    switch (entry.type) {
+    switch (entry->type) {
         case NodeType::EXACT:
             return true;
         case NodeType::LOWER_BOUND:
@@ -746,11 +1908,126 @@ bool AdvancedAI::probeTranspositionTable(uint64_t hash, int depth, int alpha, in
     return false;
 }
 
+// Share of the table filled by the current search, in permille, estimated from the first slots
+int AdvancedAI::transpositionTableUsage() const {
+    int used = 0;
+    for (size_t i = 0; i < 1000; ++i) {
+        if (transpositionTable[i].depth >= 0 && transpositionTable[i].generation == ttGeneration) used++;
+    }
+    return used;
+}
+
+/**
+ * TIME MANAGEMENT
+ * 
+ * With a game clock the budget for a move is an even share of the remaining
+ * time over the moves left in the period (30 assumed for sudden death), plus
+ * most of the increment. The per-move time limit of the difficulty level stays
+ * an upper bound, and a small reserve is always kept back for move overhead.
+ */
+void AdvancedAI::updateClock(int timeLeftMs, int incrementMs, int movesToGo) {
+    clockTimeLeft = timeLeftMs;
+    clockIncrement = incrementMs;
+    clockMovesToGo = movesToGo;
+}
+
+int AdvancedAI::allocateMoveTime() const {
+    if (clockTimeLeft < 0) {
+        return timeLimit;
+    }
+    
+    const int moveOverhead = 50; // milliseconds kept in reserve
+    int movesToGo = clockMovesToGo > 0 ? clockMovesToGo : 30;
+    int budget = clockTimeLeft / movesToGo + clockIncrement * 3 / 4;
+    budget = min(budget, clockTimeLeft - moveOverhead);
+    
+    return max(1, min(budget, timeLimit));
+}
+
 // Utility methods
 bool AdvancedAI::isTimeUp(chrono::steady_clock::time_point startTime) const {
     auto now = chrono::steady_clock::now();
     auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - startTime);
-    return elapsed.count() >= timeLimit;
+    return !pondering && elapsed.count() >= moveTimeLimit;
+}
+
+/**
+ * SEARCH LIMITS
+ * 
+ * The search stops when the node limit is reached or, outside deterministic
+ * mode, when the move's time runs out. Node and depth limits don't depend on
+ * machine load, so in deterministic mode the same search always visits the
+ * same nodes.
+ */
+bool AdvancedAI::shouldStopSearch(chrono::steady_clock::time_point startTime) const {
+    if (searchStopped) {
+        return true;
+    }
+    
+    if (nodeLimit > 0 && nodesSearched + quiescenceNodes >= nodeLimit) {
+        searchStopped = true;
+    } else if (!deterministic && isTimeUp(startTime)) {
+        searchStopped = true;
+    }
+    
+    return searchStopped;
+}
+
+void AdvancedAI::resetSearchState() const {
+    transpositionTable.assign(TT_SIZE, TTEntry());
+    ttGeneration = 0;
+    evalCache.assign(EVAL_CACHE_SIZE, EvalEntry());
+    materialTable.assign(MATERIAL_TABLE_SIZE, MaterialEntry());
+    pawnTable.assign(PAWN_TABLE_SIZE, PawnEntry());
+    
+    for (int i = 0; i < 64; ++i) {
+        killerMoves[i][0] = Move();
+        killerMoves[i][1] = Move();
+    }
+    
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            for (int k = 0; k < 8; ++k) {
+                for (int l = 0; l < 8; ++l) {
+                    historyTable[i][j][k][l] = 0;
+                }
+            }
+        }
+    }
+    
+    for (int piece = 0; piece < 12; ++piece) {
+        for (int sq = 0; sq < 64; ++sq) {
+            counterMoves[piece][sq] = Move();
+        }
+    }
+    
+    continuationHistory.assign(12 * 64 * 12 * 64, 0);
+    
+    for (int ply = 0; ply < MAX_PLY; ++ply) {
+        searchStack[ply] = PlyInfo{Move(), -1, false, Move(), 0};
+    }
+}
+
+/**
+ * HISTORY AGING
+ * 
+ * Halves every history score between moves, so statistics from earlier
+ * positions still guide ordering but fade instead of piling up.
+ */
+void AdvancedAI::ageHistory() const {
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            for (int k = 0; k < 8; ++k) {
+                for (int l = 0; l < 8; ++l) {
+                    historyTable[i][j][k][l] /= 2;
+                }
+            }
+        }
+    }
+    
+    for (int16_t& score : continuationHistory) {
+        score /= 2;
+    }
 }
 
 void AdvancedAI::updateKillerMoves(const Move& move, int depth) const {
@@ -762,8 +2039,51 @@ void AdvancedAI::updateKillerMoves(const Move& move, int depth) const {
     }
 }
 
-void AdvancedAI::updateHistoryTable(const Move& move, int depth) const {
-    historyTable[move.fromRow][move.fromCol][move.toRow][move.toCol] += depth * depth;
+// Gravity update: moves the score towards +-HISTORY_MAX, by less the closer it already is,
+// so scores saturate instead of growing without bound
+static int applyHistoryBonus(int score, int bonus, int maxScore) {
+    return score + bonus - score * abs(bonus) / maxScore;
+}
+
+void AdvancedAI::updateHistoryTable(const Move& move, ChessBoard& board, int ply, int bonus) const {
+    int& entry = historyTable[move.fromRow][move.fromCol][move.toRow][move.toCol];
+    entry = applyHistoryBonus(entry, bonus, HISTORY_MAX);
+    
+    Piece* piece = board.getSquare(move.fromRow, move.fromCol);
+    int pieceIndex = getPieceIndex(piece->getPieceType(), piece->getIsWhite());
+    int to = squareIndex(move.toRow, move.toCol);
+    
+    for (int back = 1; back <= 2 && ply - back >= 0; ++back) {
+        const PlyInfo& previous = searchStack[ply - back];
+        if (previous.piece < 0) break;
+        int previousTo = squareIndex(previous.move.toRow, previous.move.toCol);
+        int16_t& continuation = continuationHistory[continuationIndex(previous.piece, previousTo, pieceIndex, to)];
+        continuation = static_cast<int16_t>(applyHistoryBonus(continuation, bonus, HISTORY_MAX));
+    }
+}
+
+/**
+ * QUIET MOVE STATISTICS
+ * 
+ * On a quiet beta cutoff the move is rewarded in every history table and
+ * becomes the counter move to the opponent's previous move, while the quiet
+ * moves searched before it are penalized by the same amount.
+ */
+void AdvancedAI::updateQuietHistories(const Move& bestMove, const Move* quietsSearched, int quietCount,
+                                      ChessBoard& board, int depth, int ply) const {
+    int bonus = min(historyBonusScale * depth * depth, HISTORY_MAX / 8);
+    
+    updateHistoryTable(bestMove, board, ply, bonus);
+    for (int i = 0; i < quietCount; ++i) {
+        if (!(quietsSearched[i] == bestMove)) {
+            updateHistoryTable(quietsSearched[i], board, ply, -bonus);
+        }
+    }
+    
+    if (ply > 0 && searchStack[ply - 1].piece >= 0) {
+        const PlyInfo& previous = searchStack[ply - 1];
+        counterMoves[previous.piece][squareIndex(previous.move.toRow, previous.move.toCol)] = bestMove;
+    }
 }
 
 // Opening book (simplified)
@@ -773,7 +2093,7 @@ void AdvancedAI::initializeOpeningBook() {
 }
 
 AdvancedAI::Move AdvancedAI::getOpeningMove(ChessBoard& board) const {
-    uint64_t hash = computeZobristHash(board);
+    uint64_t hash = computeZobristHash(board, isWhite);
     auto it = openingBook.find(hash);
     if (it != openingBook.end() && !it->second.empty()) {
         return it->second[0]; // Return first book move
@@ -787,7 +2107,14 @@ void AdvancedAI::printSearchStatistics() const {
     cout << "Transposition hits: " << transpositionHits << endl;
     cout << "Alpha-beta cutoffs: " << alphaBetaCutoffs << endl;
     cout << "Quiescence nodes: " << quiescenceNodes << endl;
-    cout << "TT size: " << transpositionTable.size() << endl;
+    cout << "Eval cache hits: " << evalCacheHits << endl;
+    if (evaluations > 0) {
+        cout << "Lazy evaluations: " << lazyEvaluations << " (" << lazyEvaluations * 1000 / evaluations / 10.0 << "%)" << endl;
+    }
+    if (pawnTableProbes > 0) {
+        cout << "Pawn table hits: " << pawnTableHits * 1000 / pawnTableProbes / 10.0 << "%" << endl;
+    }
+    cout << "TT usage: " << transpositionTableUsage() / 10.0 << "%" << endl;
 }
 
 void AdvancedAI::clearStatistics() const {
@@ -795,4 +2122,9 @@ void AdvancedAI::clearStatistics() const {
     transpositionHits = 0;
     alphaBetaCutoffs = 0;
     quiescenceNodes = 0;
+    evalCacheHits = 0;
+    evaluations = 0;
+    lazyEvaluations = 0;
+    pawnTableProbes = 0;
+    pawnTableHits = 0;
 }
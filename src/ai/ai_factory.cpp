@@ -73,17 +73,35 @@ unique_ptr<Player> AIFactory::createAdvancedAI(bool isWhite, int maxDepth,
         ai->enableQuiescenceSearch(true);
         ai->enableNullMovePruning(true);
         ai->enablePrincipalVariationSearch(true);
+        ai->enableLazyEvaluation(true);
     } else {
         ai->enableIterativeDeepening(false);
         ai->enableTranspositionTable(false);
         ai->enableQuiescenceSearch(false);
         ai->enableNullMovePruning(false);
         ai->enablePrincipalVariationSearch(false);
+        ai->enableLazyEvaluation(false);
     }
     
     return std::move(ai);
 }
 
+unique_ptr<AdvancedAI> AIFactory::createAnalysisAI(bool isWhite, int lines, int timeLimit) {
+    auto ai = make_unique<AdvancedAI>(isWhite, 8);
+    
+    // Analysis runs on time alone, with the full Grandmaster search
+    ai->setMaxDepth(64);
+    ai->setTimeLimit(timeLimit);
+    ai->setMultiPV(lines);
+    ai->enableIterativeDeepening(true);
+    ai->enableTranspositionTable(true);
+    ai->enableQuiescenceSearch(true);
+    ai->enableNullMovePruning(true);
+    ai->enablePrincipalVariationSearch(true);
+    
+    return ai;
+}
+
 string AIFactory::getAIDescription(int difficulty) {
     switch (difficulty) {
         case 1:
@@ -119,6 +137,7 @@ void printAIAlgorithmInfo() {
     cout << "• Advanced Move Ordering (killer moves, history heuristic)" << endl;
     cout << "• Sophisticated Evaluation Function" << endl;
     cout << "• Piece-Square Tables" << endl;
+    cout << "• NNUE Evaluation (HalfKP, after 'nnue <file>')" << endl;
     cout << "• Opening Book Integration" << endl;
     
     cout << "\nDifficulty Levels:" << endl;
@@ -0,0 +1,107 @@
+#include "endgame.h"
+#include "zobrist.h"
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+using namespace std;
+
+// piece values in centipawns (p, n, b, r, q, k), as in the general evaluation
+static const int pieceValues[6] = {100, 320, 330, 500, 900, 0};
+
+static const int PUSH_TO_EDGE_WEIGHT = 20; // per step the weak king stands from the centre
+static const int PUSH_CLOSE_WEIGHT = 10; // per step the kings stand closer than the full board apart
+static const int PUSH_TO_CORNER_WEIGHT = 20; // per step the weak king stands closer to a corner the bishop controls
+
+// steps from a square to the central four squares, 0 in the centre and 6 in a corner
+static int centreDistance(int sq) {
+    int row = sq / 8, col = sq % 8;
+    return max(3 - row, row - 4) + max(3 - col, col - 4);
+}
+
+// king moves between two squares
+static int kingDistance(int a, int b) {
+    return max(abs(a / 8 - b / 8), abs(a % 8 - b % 8));
+}
+
+// non-pawn material of one side, in centipawns
+static int nonPawnMaterial(const ChessBoard& board, bool isWhite) {
+    int material = 0;
+    for (int type = 1; type < 5; ++type) material += popCount(board.getPieces(isWhite, "pnbrqk"[type])) * pieceValues[type];
+    return material;
+}
+
+Endgames::Evaluator Endgames::probe(uint64_t materialKey, bool& strongIsWhite) {
+    // built on first use rather than before main, as it needs the Zobrist keys to be ready
+    static const unordered_map<uint64_t, pair<Evaluator, bool>> registry = [] {
+        const pair<const char*, Evaluator> endgames[] = {
+            {"KQK", evaluateKXK},
+            {"KRK", evaluateKXK},
+            {"KBNK", evaluateKBNK},
+        };
+        unordered_map<uint64_t, pair<Evaluator, bool>> entries;
+        for (const auto& endgame : endgames) {
+            entries[Endgames::materialKey(endgame.first, true)] = {endgame.second, true};
+            entries[Endgames::materialKey(endgame.first, false)] = {endgame.second, false};
+        }
+        return entries;
+    }();
+
+    auto it = registry.find(materialKey);
+    if (it == registry.end()) return nullptr;
+    strongIsWhite = it->second.second;
+    return it->second.first;
+}
+
+uint64_t Endgames::materialKey(const string& signature, bool strongIsWhite) {
+    // hashed the way boards hash their material: the Nth piece of a kind as if it stood on square N-1
+    uint64_t key = 0;
+    int count[2][6] = {};
+    int side = -1; // 0 for the strong side, 1 for the weak side; each king starts a side
+    for (char c : signature) {
+        char pieceType = tolower(c);
+        if (pieceType == 'k') ++side;
+        bool isWhite = (side == 0) == strongIsWhite;
+        key ^= Zobrist::piece(isWhite, pieceType, count[side][pieceTypeIndex(pieceType)]++);
+    }
+    return key;
+}
+
+/*
+ * A queen or rook mates a bare king only on the edge of the board, with the
+ * help of its own king. The score grows as the weak king is pushed out of the
+ * centre and as the kings come closer, so every step of the mating plan is an
+ * improvement the search can see long before the mate itself.
+ */
+int Endgames::evaluateKXK(const ChessBoard& board, bool strongIsWhite) {
+    int strongKing = lsb(board.getPieces(strongIsWhite, 'k'));
+    int weakKing = lsb(board.getPieces(!strongIsWhite, 'k'));
+
+    int score = KNOWN_WIN + nonPawnMaterial(board, strongIsWhite);
+    score += PUSH_TO_EDGE_WEIGHT * centreDistance(weakKing);
+    score += PUSH_CLOSE_WEIGHT * (7 - kingDistance(strongKing, weakKing));
+    return strongIsWhite ? score : -score;
+}
+
+/*
+ * Bishop and knight mate only in a corner of the bishop's colour; in the
+ * other two corners the weak king is safe. The weak king is pushed to the
+ * edge and then along it towards the nearer of the right corners.
+ */
+int Endgames::evaluateKBNK(const ChessBoard& board, bool strongIsWhite) {
+    int strongKing = lsb(board.getPieces(strongIsWhite, 'k'));
+    int weakKing = lsb(board.getPieces(!strongIsWhite, 'k'));
+    int bishop = lsb(board.getPieces(strongIsWhite, 'b'));
+
+    // a1 is a dark square, so a dark-squared bishop mates on a1 or h8, a light-squared one on h1 or a8
+    bool darkBishop = (bishop / 8 + bishop % 8) % 2 == 0;
+    int cornerDistance = darkBishop ? min(kingDistance(weakKing, 0), kingDistance(weakKing, 63))
+                                    : min(kingDistance(weakKing, 7), kingDistance(weakKing, 56));
+
+    int score = KNOWN_WIN + nonPawnMaterial(board, strongIsWhite);
+    score += PUSH_TO_CORNER_WEIGHT * (7 - cornerDistance);
+    score += PUSH_TO_EDGE_WEIGHT / 2 * centreDistance(weakKing);
+    score += PUSH_CLOSE_WEIGHT * (7 - kingDistance(strongKing, weakKing));
+    return strongIsWhite ? score : -score;
+}
@@ -0,0 +1,86 @@
+#include "bitboard.h"
+#include <cstdlib>
+using namespace std;
+
+Bitboard Bitboards::knightTable[64];
+Bitboard Bitboards::kingTable[64];
+Bitboard Bitboards::pawnTable[2][64];
+Bitboard Bitboards::rayTable[8][64];
+Bitboard Bitboards::betweenTable[64][64];
+
+// ray directions as {row, col} steps: rook directions first, then bishop directions
+// directions 0, 1, 4 and 5 increase the square index, the others decrease it
+static const int directions[8][2] = {
+    {1, 0}, {0, 1}, {-1, 0}, {0, -1},
+    {1, 1}, {1, -1}, {-1, -1}, {-1, 1}
+};
+
+// builds the tables once before main runs, so lookups never need an initialization check
+static struct BitboardInitializer {
+    BitboardInitializer() { Bitboards::init(); }
+} bitboardInitializer;
+
+// adds a square to a set if it is on the board
+static void addSquare(Bitboard& b, int row, int col) {
+    if (row >= 0 && row < 8 && col >= 0 && col < 8) {
+        b |= squareBit(row, col);
+    }
+}
+
+void Bitboards::init() {
+    const int knightSteps[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+
+    for (int sq = 0; sq < 64; ++sq) {
+        int row = sq / 8;
+        int col = sq % 8;
+
+        knightTable[sq] = 0;
+        kingTable[sq] = 0;
+        for (int i = 0; i < 8; ++i) {
+            addSquare(knightTable[sq], row + knightSteps[i][0], col + knightSteps[i][1]);
+            addSquare(kingTable[sq], row + directions[i][0], col + directions[i][1]);
+        }
+
+        pawnTable[0][sq] = 0;
+        pawnTable[1][sq] = 0;
+        addSquare(pawnTable[0][sq], row + 1, col - 1);
+        addSquare(pawnTable[0][sq], row + 1, col + 1);
+        addSquare(pawnTable[1][sq], row - 1, col - 1);
+        addSquare(pawnTable[1][sq], row - 1, col + 1);
+
+        for (int d = 0; d < 8; ++d) {
+            rayTable[d][sq] = 0;
+            for (int r = row + directions[d][0], c = col + directions[d][1]; r >= 0 && r < 8 && c >= 0 && c < 8; r += directions[d][0], c += directions[d][1]) {
+                rayTable[d][sq] |= squareBit(r, c);
+            }
+        }
+    }
+
+    // the squares between two squares are the part of the ray from the first that stops short of the second
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            betweenTable[a][b] = 0;
+            for (int d = 0; d < 8; ++d) {
+                if (rayTable[d][a] & (1ULL << b)) {
+                    betweenTable[a][b] = rayTable[d][a] & ~rayTable[d][b] & ~(1ULL << b);
+                }
+            }
+        }
+    }
+}
+
+// classical ray attacks: each empty-board ray is cut off behind its nearest blocker
+Bitboard Bitboards::slidingAttacks(int sq, Bitboard occupied, int firstDirection) {
+    Bitboard attacks = 0;
+    for (int d = firstDirection; d < firstDirection + 4; ++d) {
+        Bitboard ray = rayTable[d][sq];
+        Bitboard blockers = ray & occupied;
+        if (blockers) {
+            bool increasing = (d == 0 || d == 1 || d == 4 || d == 5);
+            int blocker = increasing ? lsb(blockers) : msb(blockers);
+            ray ^= rayTable[d][blocker];
+        }
+        attacks |= ray;
+    }
+    return attacks;
+}
@@ -49,6 +49,18 @@ ChessBoard::ChessBoard(const ChessBoard& other) {
         Piece* p = other.blackPieces[i].get();
         placePiece(p->getRow(), p->getCol(), p->getIsWhite(), p->getPieceType(), p->getHasMoved());
     }
+
+    // the en passant pawn is the copy of the other board's en passant pawn
+    enPassantPawn = nullptr;
+    Piece* otherEnPassantPawn = other.getEnPassantPawn();
+    setEnPassantPawn(otherEnPassantPawn != nullptr ? getSquare(otherEnPassantPawn->getRow(), otherEnPassantPawn->getCol()) : nullptr);
+
+    // the copy continues the same game, so it shares the history used for the draw rules
+    halfmoveClock = other.halfmoveClock;
+    keyHistory = other.keyHistory;
+
+    // the pieces were placed with nothing to update yet, so the network's sums are taken over as they are
+    accumulator = other.accumulator;
 }
 
 ChessBoard::~ChessBoard() {}
@@ -76,10 +88,72 @@ Piece* ChessBoard::getSquare(int row, int col) const {
     return board[row][col];
 }
 
+// sets the bit of a piece's square in its colour and type bitboards, and adds the piece to the keys and scores
+void ChessBoard::addToBitboards(Piece* p) {
+    int sq = squareIndex(p->getRow(), p->getCol());
+    Bitboard bit = 1ULL << sq;
+    int colour = p->getIsWhite() ? 0 : 1;
+    int type = pieceTypeIndex(p->getPieceType());
+    pieceBitboards[colour][type] |= bit;
+    colourBitboards[colour] |= bit;
+    // the Nth piece of a type is hashed in as if it stood on square N - 1, so the key only depends on the counts
+    materialKey ^= Zobrist::piece(p->getIsWhite(), p->getPieceType(), popCount(pieceBitboards[colour][type]) - 1);
+    uint64_t pieceHash = Zobrist::piece(p->getIsWhite(), p->getPieceType(), sq);
+    pieceKey ^= pieceHash;
+    if (p->getPieceType() == 'p') { pawnKey ^= pieceHash; }
+    midgameScore += PSQT::midgame(p->getIsWhite(), p->getPieceType(), sq);
+    endgameScore += PSQT::endgame(p->getIsWhite(), p->getPieceType(), sq);
+    phase += PSQT::phase(p->getPieceType());
+    NNUE::addPiece(accumulator, pieceBitboards, colour, type, sq);
+}
+
+// clears the bit of a piece's square in its colour and type bitboards, and removes the piece from the keys and scores
+void ChessBoard::removeFromBitboards(Piece* p) {
+    int sq = squareIndex(p->getRow(), p->getCol());
+    Bitboard bit = 1ULL << sq;
+    int colour = p->getIsWhite() ? 0 : 1;
+    int type = pieceTypeIndex(p->getPieceType());
+    pieceBitboards[colour][type] &= ~bit;
+    colourBitboards[colour] &= ~bit;
+    materialKey ^= Zobrist::piece(p->getIsWhite(), p->getPieceType(), popCount(pieceBitboards[colour][type]));
+    uint64_t pieceHash = Zobrist::piece(p->getIsWhite(), p->getPieceType(), sq);
+    pieceKey ^= pieceHash;
+    if (p->getPieceType() == 'p') { pawnKey ^= pieceHash; }
+    midgameScore -= PSQT::midgame(p->getIsWhite(), p->getPieceType(), sq);
+    endgameScore -= PSQT::endgame(p->getIsWhite(), p->getPieceType(), sq);
+    phase -= PSQT::phase(p->getPieceType());
+    NNUE::removePiece(accumulator, pieceBitboards, colour, type, sq);
+}
+
+// moves a piece to an empty square, keeping the grid, bitboards, keys and scores in sync
+void ChessBoard::relocatePiece(Piece* p, int toRow, int toCol) {
+    board[p->getRow()][p->getCol()] = nullptr;
+    removeFromBitboards(p);
+    p->setCoords(toRow, toCol);
+    p->setHasMoved(true); // a moved pawn loses its double step, a moved king or rook its castling
+    board[toRow][toCol] = p;
+    addToBitboards(p);
+}
+
+// finds every piece attacking a square; sliders are traced through the given occupancy, so removing pieces from it reveals x-ray attackers behind them
+Bitboard ChessBoard::attackersTo(int sq, Bitboard occupied) const {
+    Bitboard rooksQueens = pieceBitboards[0][3] | pieceBitboards[0][4] | pieceBitboards[1][3] | pieceBitboards[1][4];
+    Bitboard bishopsQueens = pieceBitboards[0][2] | pieceBitboards[0][4] | pieceBitboards[1][2] | pieceBitboards[1][4];
+
+    return (Bitboards::pawnAttacks(false, sq) & pieceBitboards[0][0]) // white pawns attack like a black pawn standing on the square
+         | (Bitboards::pawnAttacks(true, sq) & pieceBitboards[1][0])
+         | (Bitboards::knightAttacks(sq) & (pieceBitboards[0][1] | pieceBitboards[1][1]))
+         | (Bitboards::kingAttacks(sq) & (pieceBitboards[0][5] | pieceBitboards[1][5]))
+         | (Bitboards::rookAttacks(sq, occupied) & rooksQueens)
+         | (Bitboards::bishopAttacks(sq, occupied) & bishopsQueens);
+}
+
 // removes either a white or black piece from the board
 void ChessBoard::removePiece(int row, int col) {
     Piece *p = getSquare(row, col);
     if (p == nullptr) { return; }
+    if (p == enPassantPawn) { setEnPassantPawn(nullptr); }
+    removeFromBitboards(p);
 
     // if a piece exists in the square, then remove it. Note: they are smart pointers, so we can just take them out of scope and they will delete themselves
     if (p->getIsWhite()) {
@@ -125,6 +199,7 @@ void ChessBoard::placePiece(int row, int col, bool isWhite, char pieceType, bool
 
     // add the new piece into the array of white or black pieces
     board[row][col] = p.get();
+    addToBitboards(p.get());
     if (isWhite) {
         whitePieces.emplace_back(std::move(p));
     } else {
@@ -139,6 +214,10 @@ void ChessBoard::removeAllPieces() {
             removePiece(i, j);
         }
     }
+
+    // a new position starts a new history
+    halfmoveClock = 0;
+    keyHistory.clear();
 }
 
 // retrieves the king of a certain colour by iterating through either the array of white pieces of black pieces
@@ -404,6 +483,15 @@ void ChessBoard::movePiece(int fromRow, int fromCol, int toRow, int toCol, char
     Piece *p = getSquare(fromRow, fromCol);
     if (p == nullptr) { return; }
 
+    // captures and pawn moves can't be undone, so no earlier position can occur again after them
+    if (p->getPieceType() == 'p' || getSquare(toRow, toCol) != nullptr) {
+        halfmoveClock = 0;
+        keyHistory.clear();
+    } else {
+        halfmoveClock++;
+        keyHistory.push_back(getKey());
+    }
+
     // set en passant pawn
     if (p->getPieceType() == 'p' && abs(toRow - p->getRow()) == 2) {
         setEnPassantPawn(p);
@@ -414,9 +502,9 @@ void ChessBoard::movePiece(int fromRow, int fromCol, int toRow, int toCol, char
     // moving rook for castling
     if (p->getPieceType() == 'k' && abs(fromCol - toCol) == 2) {
         if (toCol == 6) {
-            movePiece(fromRow, 7, fromRow, 5);
+            relocatePiece(getSquare(fromRow, 7), fromRow, 5);
         } else {
-            movePiece(fromRow, 0, fromRow, 3);
+            relocatePiece(getSquare(fromRow, 0), fromRow, 3);
         }
     }
 
@@ -429,9 +517,7 @@ void ChessBoard::movePiece(int fromRow, int fromCol, int toRow, int toCol, char
     if (getSquare(toRow, toCol) != nullptr) {
         removePiece(toRow, toCol);
     }
-    p->setCoords(toRow, toCol);
-    board[toRow][toCol] = p;
-    board[fromRow][fromCol] = nullptr;
+    relocatePiece(p, toRow, toCol);
 
     // pawn promotion checks
     if (p->getPieceType() == 'p' && (toRow == 0 || toRow == 7)) {
@@ -452,6 +538,8 @@ void ChessBoard::movePiece(int fromRow, int fromCol, int toRow, int toCol, char
         placePiece(toRow, toCol, pIsWhite, promotionType, true);
     }
 
+    // a king move leaves its half of the network's sums to be rebuilt; doing it now lets the boards copied from this one start up to date
+    NNUE::refresh(accumulator, pieceBitboards);
 }
 
 
@@ -496,5 +584,60 @@ Piece* ChessBoard::getEnPassantPawn() const {
 }
 
 void ChessBoard::setEnPassantPawn(Piece* p) {
+    if (enPassantPawn != nullptr) { pieceKey ^= Zobrist::enPassant(enPassantPawn->getCol()); }
     enPassantPawn = p;
+    if (enPassantPawn != nullptr) { pieceKey ^= Zobrist::enPassant(enPassantPawn->getCol()); }
+}
+
+// castling is still possible for a side while its king and that rook are unmoved on their starting squares
+int ChessBoard::getCastlingRights() const {
+    int rights = 0;
+    for (int colour = 0; colour < 2; ++colour) {
+        int row = colour == 0 ? 0 : 7;
+        bool isWhite = colour == 0;
+        Piece* king = getSquare(row, 4);
+        if (king == nullptr || king->getPieceType() != 'k' || king->getIsWhite() != isWhite || king->getHasMoved()) { continue; }
+
+        Piece* kingsideRook = getSquare(row, 7);
+        Piece* queensideRook = getSquare(row, 0);
+        if (kingsideRook != nullptr && kingsideRook->getPieceType() == 'r' && kingsideRook->getIsWhite() == isWhite && !kingsideRook->getHasMoved()) {
+            rights |= isWhite ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+        }
+        if (queensideRook != nullptr && queensideRook->getPieceType() == 'r' && queensideRook->getIsWhite() == isWhite && !queensideRook->getHasMoved()) {
+            rights |= isWhite ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+        }
+    }
+    return rights;
+}
+
+// positions with the same side to move are an even number of moves apart, and the history only goes back to the last irreversible move
+bool ChessBoard::isRepetition(int times) const {
+    uint64_t key = getKey();
+    int found = 0;
+    for (int i = static_cast<int>(keyHistory.size()) - 2; i >= 0; i -= 2) {
+        if (keyHistory[i] == key && ++found >= times) { return true; }
+    }
+    return false;
+}
+
+// Upcoming repetition test using the cuckoo table of reversible moves: an earlier position that differs from this
+// one by a single piece standing on another square is one move away when that piece belongs to the side to move and
+// nothing stands between the two squares. Only positions an odd number of moves back have the other side to move,
+// which is what they will have after the move.
+bool ChessBoard::hasUpcomingRepetition(bool whiteToMove) const {
+    int end = static_cast<int>(keyHistory.size());
+    if (end < 3) { return false; }
+
+    uint64_t key = getKey();
+    Bitboard occupied = getOccupied();
+    for (int i = 3; i <= end; i += 2) {
+        int sq1, sq2;
+        if (!Zobrist::findReversibleMove(key ^ keyHistory[end - i], sq1, sq2)) { continue; }
+        if (Bitboards::between(sq1, sq2) & occupied) { continue; }
+
+        Piece* p = getSquare(sq1 / 8, sq1 % 8);
+        if (p == nullptr) { p = getSquare(sq2 / 8, sq2 % 8); }
+        if (p != nullptr && p->getIsWhite() == whiteToMove) { return true; }
+    }
+    return false;
 }
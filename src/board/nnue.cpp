@@ -0,0 +1,266 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NNUE_MMAP // weights are mapped from the file instead of read into memory
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 // the SIMD kernels can be compiled; whether they run is decided by the CPU
+#endif
+using namespace std;
+
+const int16_t* NNUE::featureBiases = nullptr;
+const int16_t* NNUE::featureWeights = nullptr;
+const int32_t* NNUE::hidden1Biases = nullptr;
+const int8_t* NNUE::hidden1Weights = nullptr;
+const int32_t* NNUE::hidden2Biases = nullptr;
+const int8_t* NNUE::hidden2Weights = nullptr;
+const int8_t* NNUE::outputWeights = nullptr;
+const int32_t* NNUE::outputBias = nullptr;
+uint32_t NNUE::networkGeneration = 0;
+void (*NNUE::affineKernel)(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) = NNUE::affineScalar;
+
+// the loaded network's bytes: a mapping of the file, or a copy of it where files cannot be mapped
+#ifdef NNUE_MMAP
+static void* mappedData = nullptr;
+static size_t mappedSize = 0;
+#else
+static vector<char> fileData;
+#endif
+
+// bytes of a network file with the current dimensions
+static const size_t NETWORK_FILE_SIZE = NNUE::HEADER_SIZE
+    + sizeof(int16_t) * NNUE::HALF_DIMENSIONS + sizeof(int16_t) * NNUE::INPUTS * NNUE::HALF_DIMENSIONS
+    + sizeof(int32_t) * NNUE::HIDDEN + sizeof(int8_t) * NNUE::HIDDEN * 2 * NNUE::HALF_DIMENSIONS
+    + sizeof(int32_t) * NNUE::HIDDEN + sizeof(int8_t) * NNUE::HIDDEN * NNUE::HIDDEN
+    + sizeof(int8_t) * NNUE::HIDDEN + sizeof(int32_t);
+
+bool NNUE::load(const string& path) {
+    const char* data = nullptr;
+#ifdef NNUE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size != NETWORK_FILE_SIZE) {
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, NETWORK_FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid without the descriptor
+    if (mapping == MAP_FAILED) return false;
+    data = static_cast<const char*>(mapping);
+#else
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+    vector<char> contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (contents.size() != NETWORK_FILE_SIZE) return false;
+    data = contents.data();
+#endif
+
+    uint32_t dimensions[4];
+    memcpy(dimensions, data + 4, sizeof(dimensions));
+    if (memcmp(data, MAGIC, 4) != 0 || dimensions[0] != FILE_VERSION || dimensions[1] != (uint32_t)INPUTS ||
+        dimensions[2] != (uint32_t)HALF_DIMENSIONS || dimensions[3] != (uint32_t)HIDDEN) {
+#ifdef NNUE_MMAP
+        munmap(mapping, NETWORK_FILE_SIZE);
+#endif
+        return false;
+    }
+
+    // the file is valid: release the previous network and point at the new one's sections
+#ifdef NNUE_MMAP
+    if (mappedData) munmap(mappedData, mappedSize);
+    mappedData = mapping;
+    mappedSize = NETWORK_FILE_SIZE;
+#else
+    fileData.swap(contents);
+    data = fileData.data();
+#endif
+    const char* section = data + HEADER_SIZE;
+    featureBiases = reinterpret_cast<const int16_t*>(section);
+    section += sizeof(int16_t) * HALF_DIMENSIONS;
+    featureWeights = reinterpret_cast<const int16_t*>(section);
+    section += sizeof(int16_t) * INPUTS * HALF_DIMENSIONS;
+    hidden1Biases = reinterpret_cast<const int32_t*>(section);
+    section += sizeof(int32_t) * HIDDEN;
+    hidden1Weights = reinterpret_cast<const int8_t*>(section);
+    section += sizeof(int8_t) * HIDDEN * 2 * HALF_DIMENSIONS;
+    hidden2Biases = reinterpret_cast<const int32_t*>(section);
+    section += sizeof(int32_t) * HIDDEN;
+    hidden2Weights = reinterpret_cast<const int8_t*>(section);
+    section += sizeof(int8_t) * HIDDEN * HIDDEN;
+    outputWeights = reinterpret_cast<const int8_t*>(section);
+    section += sizeof(int8_t) * HIDDEN;
+    outputBias = reinterpret_cast<const int32_t*>(section);
+    networkGeneration++;
+
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    affineKernel = __builtin_cpu_supports("avx2") ? affineAVX2
+                 : __builtin_cpu_supports("ssse3") ? affineSSSE3 : affineScalar;
+#endif
+    return true;
+}
+
+// one column of first-layer weights per feature, added or subtracted for both perspectives; a king move changes every feature of its own perspective, so that half is rebuilt instead
+void NNUE::updatePiece(Accumulator& accumulator, const Bitboard pieces[2][6], int colour, int type, int sq, bool add) {
+    if (type == 5) {
+        accumulator.valid[colour] = false;
+        return;
+    }
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        if (!accumulator.valid[perspective]) continue;
+        const int16_t* column = featureWeights + featureIndex(perspective, lsb(pieces[perspective][5]), colour, type, sq) * HALF_DIMENSIONS;
+        int16_t* values = accumulator.values[perspective];
+        if (add) {
+            for (int i = 0; i < HALF_DIMENSIONS; ++i) values[i] += column[i];
+        } else {
+            for (int i = 0; i < HALF_DIMENSIONS; ++i) values[i] -= column[i];
+        }
+    }
+}
+
+void NNUE::rebuild(Accumulator& accumulator, const Bitboard pieces[2][6]) {
+    if (accumulator.generation != networkGeneration) {
+        accumulator.valid[0] = accumulator.valid[1] = false;
+        accumulator.generation = networkGeneration;
+    }
+
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        if (accumulator.valid[perspective] || !pieces[perspective][5]) continue; // a board being set up may not have its king yet
+        int kingSq = lsb(pieces[perspective][5]);
+        int16_t* values = accumulator.values[perspective];
+        memcpy(values, featureBiases, sizeof(int16_t) * HALF_DIMENSIONS);
+        for (int colour = 0; colour < 2; ++colour) {
+            for (int type = 0; type < 5; ++type) {
+                for (Bitboard b = pieces[colour][type]; b; ) {
+                    const int16_t* column = featureWeights + featureIndex(perspective, kingSq, colour, type, popLsb(b)) * HALF_DIMENSIONS;
+                    for (int i = 0; i < HALF_DIMENSIONS; ++i) values[i] += column[i];
+                }
+            }
+        }
+        accumulator.valid[perspective] = true;
+    }
+}
+
+// clips a layer's sums, scaled by ACTIVATION_SCALE * WEIGHT_SCALE, into activations in 0..ACTIVATION_SCALE
+static void clipActivations(const int32_t* sums, int count, uint8_t* activations) {
+    for (int i = 0; i < count; ++i) activations[i] = (uint8_t)max(0, min((int)NNUE::ACTIVATION_SCALE, sums[i] / NNUE::WEIGHT_SCALE));
+}
+
+int NNUE::evaluate(const Accumulator& accumulator) {
+    alignas(32) uint8_t input[2 * HALF_DIMENSIONS];
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        const int16_t* values = accumulator.values[perspective];
+        uint8_t* half = input + perspective * HALF_DIMENSIONS;
+        for (int i = 0; i < HALF_DIMENSIONS; ++i) {
+            half[i] = values[i] < 0 ? 0 : values[i] > ACTIVATION_SCALE ? ACTIVATION_SCALE : values[i]; // kept simple so the compiler vectorizes it
+        }
+    }
+
+    alignas(32) int32_t sums[HIDDEN];
+    alignas(32) uint8_t hidden1[HIDDEN], hidden2[HIDDEN];
+    affineKernel(input, 2 * HALF_DIMENSIONS, hidden1Weights, hidden1Biases, HIDDEN, sums);
+    clipActivations(sums, HIDDEN, hidden1);
+    affineKernel(hidden1, HIDDEN, hidden2Weights, hidden2Biases, HIDDEN, sums);
+    clipActivations(sums, HIDDEN, hidden2);
+    int32_t output;
+    affineKernel(hidden2, HIDDEN, outputWeights, outputBias, 1, &output);
+    return output * 100 / (ACTIVATION_SCALE * WEIGHT_SCALE); // pawns to centipawns
+}
+
+void NNUE::affineScalar(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) {
+    for (int o = 0; o < outputs; ++o) {
+        const int8_t* row = weights + o * inputs;
+        int32_t sum = biases[o];
+        for (int i = 0; i < inputs; ++i) sum += row[i] * input[i];
+        out[o] = sum;
+    }
+}
+
+#ifdef NNUE_X86
+// Unsigned activations times signed weights, multiplied and added in pairs to
+// 16 bits (127 * 128 * 2 cannot saturate), then in pairs again to 32 bits.
+// Four outputs are summed side by side, sharing the input loads and keeping
+// four independent chains of additions in flight, then reduced together.
+__attribute__((target("ssse3")))
+void NNUE::affineSSSE3(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) {
+    const __m128i ones = _mm_set1_epi16(1);
+    int o = 0;
+    for (; o + 4 <= outputs; o += 4) {
+        __m128i sum[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+        for (int i = 0; i < inputs; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            for (int k = 0; k < 4; ++k) {
+                __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + (o + k) * inputs + i));
+                sum[k] = _mm_add_epi32(sum[k], _mm_madd_epi16(_mm_maddubs_epi16(a, w), ones));
+            }
+        }
+        __m128i total = _mm_hadd_epi32(_mm_hadd_epi32(sum[0], sum[1]), _mm_hadd_epi32(sum[2], sum[3])); // lane k holds output o + k
+        total = _mm_add_epi32(total, _mm_loadu_si128(reinterpret_cast<const __m128i*>(biases + o)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), total);
+    }
+    for (; o < outputs; ++o) {
+        const int8_t* row = weights + o * inputs;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < inputs; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(a, w), ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E)); // swap 64-bit halves
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1)); // swap neighbouring lanes
+        out[o] = biases[o] + _mm_cvtsi128_si32(sum);
+    }
+}
+
+// the SSSE3 kernel at twice the width
+__attribute__((target("avx2")))
+void NNUE::affineAVX2(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    int o = 0;
+    for (; o + 4 <= outputs; o += 4) {
+        __m256i sum[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+        for (int i = 0; i < inputs; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            for (int k = 0; k < 4; ++k) {
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + (o + k) * inputs + i));
+                sum[k] = _mm256_add_epi32(sum[k], _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+            }
+        }
+        __m256i total = _mm256_hadd_epi32(_mm256_hadd_epi32(sum[0], sum[1]), _mm256_hadd_epi32(sum[2], sum[3])); // each half: lane k holds part of output o + k
+        __m128i halves = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+        halves = _mm_add_epi32(halves, _mm_loadu_si128(reinterpret_cast<const __m128i*>(biases + o)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), halves);
+    }
+    for (; o < outputs; ++o) {
+        const int8_t* row = weights + o * inputs;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < inputs; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        out[o] = biases[o] + _mm_cvtsi128_si32(half);
+    }
+}
+#else
+// no SSSE3 or AVX2 on this architecture; load never selects them
+void NNUE::affineSSSE3(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) {
+    affineScalar(input, inputs, weights, biases, outputs, out);
+}
+
+void NNUE::affineAVX2(const uint8_t* input, int inputs, const int8_t* weights, const int32_t* biases, int outputs, int32_t* out) {
+    affineScalar(input, inputs, weights, biases, outputs, out);
+}
+#endif
@@ -0,0 +1,25 @@
+#include "psqt.h"
+#include "psqt_tables.h"
+using namespace std;
+
+int PSQT::midgameValues[12][64];
+int PSQT::endgameValues[12][64];
+const int PSQT::phaseWeights[6] = {0, 1, 1, 2, 4, 0};
+
+// builds the tables once before main runs, so boards can score pieces as soon as they are placed
+static struct PSQTInitializer {
+    PSQTInitializer() { PSQT::init(); }
+} psqtInitializer;
+
+void PSQT::init() {
+    for (int type = 0; type < 6; ++type) {
+        for (int sq = 0; sq < 64; ++sq) {
+            int row = sq / 8, col = sq % 8;
+            // white reads its rank from the bottom of the table, black from the top
+            midgameValues[type][sq] = midgamePieceValues[type] + midgameTables[type][7 - row][col];
+            endgameValues[type][sq] = endgamePieceValues[type] + endgameTables[type][7 - row][col];
+            midgameValues[type + 6][sq] = -(midgamePieceValues[type] + midgameTables[type][row][col]);
+            endgameValues[type + 6][sq] = -(endgamePieceValues[type] + endgameTables[type][row][col]);
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include "zobrist.h"
+#include <random>
+#include <utility>
+using namespace std;
+
+uint64_t Zobrist::pieceKeys[12][64];
+uint64_t Zobrist::blackToMoveKey;
+uint64_t Zobrist::castlingKeys[16];
+uint64_t Zobrist::enPassantKeys[8];
+uint64_t Zobrist::cuckooKeys[CUCKOO_SIZE];
+uint16_t Zobrist::cuckooMoves[CUCKOO_SIZE];
+
+// fills the keys once before main runs, so boards can hash pieces as soon as they are placed
+static struct ZobristInitializer {
+    ZobristInitializer() { Zobrist::init(); }
+} zobristInitializer;
+
+void Zobrist::init() {
+    // a fixed seed keeps hash keys, and with them search behaviour and node counts, identical from run to run
+    mt19937_64 gen(0x9E3779B97F4A7C15ULL);
+    uniform_int_distribution<uint64_t> dis;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        for (int piece = 0; piece < 12; ++piece) {
+            pieceKeys[piece][sq] = dis(gen);
+        }
+    }
+
+    blackToMoveKey = dis(gen);
+
+    // each right has its own key; a mask's key is the XOR of the keys of its rights
+    uint64_t rightKeys[4];
+    for (int i = 0; i < 4; ++i) {
+        rightKeys[i] = dis(gen);
+    }
+    for (int mask = 0; mask < 16; ++mask) {
+        castlingKeys[mask] = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (mask & (1 << i)) { castlingKeys[mask] ^= rightKeys[i]; }
+        }
+    }
+
+    for (int col = 0; col < 8; ++col) {
+        enPassantKeys[col] = dis(gen);
+    }
+
+    initCuckoo();
+}
+
+// Every non-pawn move between two squares can be undone, so it is stored once for both directions.
+// Each key has two candidate slots; inserting into an occupied slot evicts the old entry to its other
+// slot, and so on until an empty slot is found. All 3668 moves fit in the 8192 slots.
+void Zobrist::initCuckoo() {
+    Bitboards::init(); // attack tables from another file may not be built yet during static initialization
+
+    for (int i = 0; i < CUCKOO_SIZE; ++i) {
+        cuckooKeys[i] = 0;
+        cuckooMoves[i] = 0;
+    }
+
+    const char pieceTypes[5] = {'n', 'b', 'r', 'q', 'k'};
+    for (int colour = 0; colour < 2; ++colour) {
+        for (char pieceType : pieceTypes) {
+            for (int sq1 = 0; sq1 < 64; ++sq1) {
+                Bitboard targets;
+                switch (pieceType) {
+                    case 'n': targets = Bitboards::knightAttacks(sq1); break;
+                    case 'b': targets = Bitboards::bishopAttacks(sq1, 0); break;
+                    case 'r': targets = Bitboards::rookAttacks(sq1, 0); break;
+                    case 'q': targets = Bitboards::queenAttacks(sq1, 0); break;
+                    default: targets = Bitboards::kingAttacks(sq1); break;
+                }
+
+                for (int sq2 = sq1 + 1; sq2 < 64; ++sq2) {
+                    if (!(targets & (1ULL << sq2))) { continue; }
+
+                    uint64_t key = piece(colour == 0, pieceType, sq1) ^ piece(colour == 0, pieceType, sq2);
+                    uint16_t move = static_cast<uint16_t>(sq1 | (sq2 << 6));
+                    int slot = cuckooSlot1(key);
+                    while (true) {
+                        swap(cuckooKeys[slot], key);
+                        swap(cuckooMoves[slot], move);
+                        if (move == 0) { break; } // the slot was empty
+                        slot = (slot == cuckooSlot1(key)) ? cuckooSlot2(key) : cuckooSlot1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool Zobrist::findReversibleMove(uint64_t keyDifference, int& sq1, int& sq2) {
+    int slot = cuckooSlot1(keyDifference);
+    if (cuckooKeys[slot] != keyDifference) {
+        slot = cuckooSlot2(keyDifference);
+        if (cuckooKeys[slot] != keyDifference) { return false; }
+    }
+    sq1 = cuckooMoves[slot] & 63;
+    sq2 = cuckooMoves[slot] >> 6;
+    return true;
+}
@@ -1,23 +1,54 @@
 #include "game.h"
+#include "ai_factory.h"
+#include "advanced_ai.h"
+#include <chrono>
+#include <iomanip>
 using namespace std;
 
 #ifndef NO_GRAPHICS
 Game::Game(Xwindow* window): scoreWhite{0}, scoreBlack{0}, textDisplay{make_unique<TextObserver>()},
                             graphicalDisplay{window != nullptr ? make_unique<GraphicalObserver>(*window, 8) : nullptr}, 
                             board{make_unique<ChessBoard>(textDisplay.get(), graphicalDisplay.get())},
-                            isWhiteTurn{true}, setupMode{false} {
+                            isWhiteTurn{true}, setupMode{false}, timeLeftWhite{0}, timeLeftBlack{0},
+                            movesPlayedWhite{0}, movesPlayedBlack{0} {
     cout << "Chess Engine initialized with " << (window ? "graphics" : "console mode") << endl;
 }
 #else
 Game::Game(void* unused): scoreWhite{0}, scoreBlack{0}, textDisplay{make_unique<TextObserver>()},
                          board{make_unique<ChessBoard>(textDisplay.get(), nullptr)},
-                         isWhiteTurn{true}, setupMode{false} {
+                         isWhiteTurn{true}, setupMode{false}, timeLeftWhite{0}, timeLeftBlack{0},
+                         movesPlayedWhite{0}, movesPlayedBlack{0} {
     cout << "Chess Engine initialized in console mode" << endl;
 }
 #endif
 
 Game::~Game() {}
 
+// parses a PGN style time control in seconds: "300" (sudden death), "300+2" (with increment) or "40/5400" (moves per period)
+bool TimeControl::parse(const string& spec, TimeControl& tc) {
+    TimeControl result;
+    string rest = spec;
+
+    size_t slash = rest.find('/');
+    if (slash != string::npos) {
+        try { result.movesPerPeriod = stoi(rest.substr(0, slash)); } catch (...) { return false; }
+        if (result.movesPerPeriod <= 0) { return false; }
+        rest = rest.substr(slash + 1);
+    }
+
+    size_t plus = rest.find('+');
+    try {
+        result.baseMs = static_cast<int>(stod(rest.substr(0, plus)) * 1000);
+        if (plus != string::npos) { result.incrementMs = static_cast<int>(stod(rest.substr(plus + 1)) * 1000); }
+    } catch (...) {
+        return false;
+    }
+
+    if (result.baseMs <= 0 || result.incrementMs < 0) { return false; }
+    tc = result;
+    return true;
+}
+
 void Game::setupNormalBoard() {
     board->removeAllPieces();
     isWhiteTurn = true;
@@ -51,28 +82,80 @@ void Game::setupNormalBoard() {
 }
 
 bool Game::runTurn() {
-    if (isWhiteTurn) {
-        return pWhite->makeMove(*board);
-    } else {
-        return pBlack->makeMove(*board);
+    Player* player = isWhiteTurn ? pWhite.get() : pBlack.get();
+
+    // tell the player how much time it has left before it starts thinking
+    if (timeControl.isTimed()) {
+        int movesPlayed = isWhiteTurn ? movesPlayedWhite : movesPlayedBlack;
+        int movesToGo = timeControl.movesPerPeriod > 0 ? timeControl.movesPerPeriod - movesPlayed % timeControl.movesPerPeriod : 0;
+        player->updateClock(isWhiteTurn ? timeLeftWhite : timeLeftBlack, timeControl.incrementMs, movesToGo);
     }
+
+    return player->makeMove(*board);
 }
 
-void Game::startGame(bool whiteIsHuman, bool blackIsHuman, int whiteDifficulty, int blackDifficulty) {
+void Game::startGame(bool whiteIsHuman, bool blackIsHuman, int whiteDifficulty, int blackDifficulty, const TimeControl& tc) {
     if(!setupMode) { isWhiteTurn = true; }
 
     if (whiteIsHuman) { pWhite = make_unique<Human>(true); } 
-    else { pWhite = make_unique<Computer>(true, whiteDifficulty); }
+    else { pWhite = AIFactory::createAI(true, whiteDifficulty); }
 
     if (blackIsHuman) { pBlack = make_unique<Human>(false); } 
-    else { pBlack = make_unique<Computer>(false, blackDifficulty); }
+    else { pBlack = AIFactory::createAI(false, blackDifficulty); }
+
+    // an engine playing a human thinks on the human's time
+    if (whiteIsHuman != blackIsHuman) { (whiteIsHuman ? pBlack : pWhite)->setPondering(true); }
+
+    // reset the clocks
+    timeControl = tc;
+    timeLeftWhite = timeLeftBlack = tc.baseMs;
+    movesPlayedWhite = movesPlayedBlack = 0;
 
     if (!setupMode) { setupNormalBoard(); } 
     board->notifyObservers();
 
     while (in) {
+        // the position before the turn, put back if the flag falls while the player is thinking
+        unique_ptr<ChessBoard> previous = timeControl.isTimed() ? make_unique<ChessBoard>(*board) : nullptr;
+        auto turnStart = chrono::steady_clock::now();
         bool result = runTurn();
+        int elapsedMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - turnStart).count());
+
+        // charge the time to the player whose turn it was; once its clock reaches zero the flag falls, and a move
+        // or resignation made after that doesn't count
+        if (timeControl.isTimed()) {
+            int& timeLeft = isWhiteTurn ? timeLeftWhite : timeLeftBlack;
+            timeLeft -= elapsedMs;
+
+            if (timeLeft <= 0) {
+                timeLeft = 0;
+                // the move was never shown; the copy has no displays attached, so they move over with it
+                previous->attach(textDisplay.get());
+#ifndef NO_GRAPHICS
+                if (graphicalDisplay) previous->attach(graphicalDisplay.get());
+#endif
+                board = std::move(previous);
+
+                string flagged = isWhiteTurn ? "white" : "black";
+                string winner = isWhiteTurn ? "black" : "white";
+                out << "Flag fall! " << flagged << " ran out of time and " << winner << " wins!" << endl;
+                if (isWhiteTurn) { scoreBlack += 1; }
+                else { scoreWhite += 1; }
+                break;
+            }
+
+            if (result) {
+                int& movesPlayed = isWhiteTurn ? movesPlayedWhite : movesPlayedBlack;
+                timeLeft += timeControl.incrementMs;
+                movesPlayed++;
+                if (timeControl.movesPerPeriod > 0 && movesPlayed % timeControl.movesPerPeriod == 0) {
+                    timeLeft += timeControl.baseMs;
+                }
+            }
+        }
+
         board->notifyObservers();
+        if (timeControl.isTimed() && result) { renderClocks(); }
 
         isWhiteTurn = !isWhiteTurn;
         string nextPlayer = isWhiteTurn ? "white" : "black";
@@ -99,11 +182,23 @@ void Game::startGame(bool whiteIsHuman, bool blackIsHuman, int whiteDifficulty,
             break;
         }
 
+        // draws by rule are declared automatically, so engine games can't shuffle forever
+        if (board->isRepetition(2) || board->isFiftyMoveDraw()) {
+            scoreWhite += 0.5;
+            scoreBlack += 0.5;
+            out << (board->isFiftyMoveDraw() ? "Draw by the fifty-move rule!" : "Draw by threefold repetition!") << endl;
+            break;
+        }
+
         if (board->checkIfKingIsInCheck(isWhiteTurn)) {
             out << nextPlayer << " is in check." << endl;
         }
         
     }
+
+    // an engine left pondering would keep searching at the menu
+    pWhite->gameOver();
+    pBlack->gameOver();
 }
 
 
@@ -201,6 +296,15 @@ void Game::setupBoard() {
 }
 
 
+void Game::renderClocks() const {
+    auto format = [](int ms) {
+        ostringstream oss;
+        oss << ms / 60000 << ":" << setw(2) << setfill('0') << (ms / 1000) % 60 << "." << (ms / 100) % 10;
+        return oss.str();
+    };
+    out << "Clock - White: " << format(timeLeftWhite) << "  Black: " << format(timeLeftBlack) << endl;
+}
+
 void Game::renderScore () const{
     out << "Final Score:" << endl;
 	out << "White: " << scoreWhite << endl;
@@ -208,3 +312,37 @@ void Game::renderScore () const{
 }
 
 
+
+// runs a multi-PV search of the position on the board (after setup or a game) and lists the lines best first
+void Game::analyzePosition(int lines, int timeLimitMs) {
+    if (board->getNumKings(true) != 1 || board->getNumKings(false) != 1) {
+        out << "Set up a position or play a game before analysing." << endl;
+        return;
+    }
+
+    unique_ptr<AdvancedAI> engine = AIFactory::createAnalysisAI(isWhiteTurn, lines, timeLimitMs);
+    vector<AdvancedAI::AnalysisLine> result = engine->analyze(*board);
+    if (result.empty()) {
+        out << "No legal moves for " << (isWhiteTurn ? "white" : "black") << "." << endl;
+        return;
+    }
+
+    out << "Best moves for " << (isWhiteTurn ? "white" : "black") << " (depth " << result[0].depth << "):" << endl;
+    for (size_t i = 0; i < result.size(); ++i) {
+        out << setw(2) << i + 1 << ". ";
+        if (result[i].mateIn != 0) {
+            out << "mate " << result[i].mateIn;
+        } else {
+            ios::fmtflags flags = out.flags();
+            streamsize precision = out.precision();
+            out << showpos << fixed << setprecision(2) << result[i].score / 100.0;
+            out.flags(flags);
+            out.precision(precision);
+        }
+        out << "  ";
+        for (const AdvancedAI::Move& move : result[i].pv) {
+            out << AdvancedAI::moveToString(move) << " ";
+        }
+        out << endl;
+    }
+}
@@ -2,6 +2,7 @@
 #define GAME_H
 #include <vector>
 #include <iostream>
+#include <string>
 #include "player.h"
 #include "human.h"
 #include "computer.h"
@@ -15,6 +16,16 @@
 
 class Player;
 
+// time control for a game; a base time of 0 means the game is untimed
+struct TimeControl {
+    int baseMs = 0; // starting time for each side
+    int incrementMs = 0; // time added after every move
+    int movesPerPeriod = 0; // moves per period, base time is added again after each period (0 is sudden death)
+
+    bool isTimed() const { return baseMs > 0; }
+    static bool parse(const std::string& spec, TimeControl& tc); // parses "300", "300+2" or "40/5400" (seconds)
+};
+
 class Game {
     std::unique_ptr<Player> pWhite;
     std::unique_ptr<Player> pBlack;
@@ -31,6 +42,13 @@ class Game {
     bool isWhiteTurn;
     bool setupMode;
 
+    // Clocks
+    TimeControl timeControl;
+    int timeLeftWhite; // milliseconds
+    int timeLeftBlack;
+    int movesPlayedWhite;
+    int movesPlayedBlack;
+
     // IO streams
     std::istream &in = std::cin;
     std::ostream &out = std::cout;
@@ -42,10 +60,12 @@ class Game {
             Game(void* unused = nullptr);
         #endif
 
-        void startGame(bool whiteIsHuman, bool blackIsHuman, int whiteDifficulty, int blackDifficulty);
+        void startGame(bool whiteIsHuman, bool blackIsHuman, int whiteDifficulty, int blackDifficulty, const TimeControl& tc = TimeControl());
         void setupNormalBoard();
         void setupBoard();  
         void renderScore() const; 
+        void renderClocks() const;
+        void analyzePosition(int lines, int timeLimitMs); // print the best lines for the side to move in the current position
         bool runTurn(); 
 
         virtual ~Game();
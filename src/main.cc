@@ -32,24 +32,31 @@
 #endif
 
         cout << "Chess Engine v2.0 - Advanced AI Edition" << endl;
-        cout << "Commands: game [white] [black], setup, quit, algorithms" << endl;
+        cout << "Commands: game [white] [black] [time control], setup, analyze [lines] [seconds], nnue [file], quit, algorithms" << endl;
         cout << "Players: human, computer1-8" << endl;
         cout << "Levels 1-4: Classic algorithms | Levels 5-8: Advanced AI" << endl;
-        cout << "Example: game human computer6" << endl;
+        cout << "Time control (seconds, optional): 300 | 300+2 | 40/5400" << endl;
+        cout << "Example: game human computer6 180+2" << endl;
         cout << "Type 'algorithms' for detailed AI information" << endl << endl;
 
         string inputLine;
         while (getline(cin, inputLine)) {
             istringstream iss{inputLine};
-            string command, whitePlayer, blackPlayer; 
-            iss >> command >> whitePlayer >> blackPlayer;
+            string command, whitePlayer, blackPlayer, timeControlSpec; 
+            iss >> command >> whitePlayer >> blackPlayer >> timeControlSpec;
 
             if (command == "game") {
+                TimeControl timeControl;
+                if (!timeControlSpec.empty() && !TimeControl::parse(timeControlSpec, timeControl)) {
+                    cerr << "Invalid time control. Use base[+increment] or moves/base in seconds." << endl;
+                    continue;
+                }
+
                 bool whiteIsHuman = whitePlayer == "human";
                 bool blackIsHuman = blackPlayer == "human";
 
                 if (whiteIsHuman && blackIsHuman) {
-                    game.startGame(true, true, -1, -1);
+                    game.startGame(true, true, -1, -1, timeControl);
                 } else if (whiteIsHuman && !blackIsHuman) {
                     int difficulty = static_cast<int>(blackPlayer.back()) - '0';
                     if (difficulty < 1 || difficulty > 8) {
@@ -57,7 +64,7 @@
                         continue;
                     }
                     cout << "Black AI: " << AIFactory::getAIDescription(difficulty) << endl;
-                    game.startGame(true, false, -1, difficulty);
+                    game.startGame(true, false, -1, difficulty, timeControl);
                 } else if (!whiteIsHuman && blackIsHuman) {
                     int difficulty = static_cast<int>(whitePlayer.back()) - '0';
                     if (difficulty < 1 || difficulty > 8) {
@@ -65,7 +72,7 @@
                         continue;
                     }
                     cout << "White AI: " << AIFactory::getAIDescription(difficulty) << endl;
-                    game.startGame(false, true, difficulty, -1);
+                    game.startGame(false, true, difficulty, -1, timeControl);
                 } else {
                     int whiteDifficulty = static_cast<int>(whitePlayer.back()) - '0';
                     int blackDifficulty = static_cast<int>(blackPlayer.back()) - '0';
@@ -76,17 +83,40 @@
                     }
                     cout << "White AI: " << AIFactory::getAIDescription(whiteDifficulty) << endl;
                     cout << "Black AI: " << AIFactory::getAIDescription(blackDifficulty) << endl;
-                    game.startGame(false, false, whiteDifficulty, blackDifficulty);
+                    game.startGame(false, false, whiteDifficulty, blackDifficulty, timeControl);
                 }
 
             } else if (command == "setup") {
                 game.setupBoard();
+            } else if (command == "analyze") {
+                // analyze [lines] [seconds], defaulting to the top 3 moves in 5 seconds
+                istringstream args{inputLine};
+                int lines = 3;
+                int seconds = 5;
+                args >> command;
+                if (!(args >> lines)) { lines = 3; }
+                else if (!(args >> seconds)) { seconds = 5; }
+                if (lines < 1 || seconds < 1) {
+                    cerr << "Usage: analyze [lines] [seconds]" << endl;
+                    continue;
+                }
+                game.analyzePosition(lines, seconds * 1000);
+            } else if (command == "nnue") {
+                // nnue <file>: levels 5-8 evaluate with a network instead of the handcrafted terms
+                istringstream args{inputLine};
+                string path;
+                args >> command >> path;
+                if (path.empty() || !NNUE::load(path)) {
+                    cerr << "Could not load a network from '" << path << "'." << endl;
+                    continue;
+                }
+                cout << "Network loaded" << (NNUE::isVectorized() ? " (SIMD)" : "") << endl;
             } else if (command == "algorithms" || command == "ai") {
                 printAIAlgorithmInfo();
             } else if (command == "quit" || command == "exit") {
                 break;
             } else {
-                cerr << "Invalid command. Use 'game', 'setup', 'algorithms', or 'quit'." << endl;
+                cerr << "Invalid command. Use 'game', 'setup', 'analyze', 'nnue', 'algorithms', or 'quit'." << endl;
             }
         }
 
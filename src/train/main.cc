@@ -0,0 +1,143 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "texel.h"
+#include "trainer.h"
+#include "training_data.h"
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage:" << endl;
+    cerr << "  chess-train pack <positions.txt> <positions.bin>" << endl;
+    cerr << "      packs '<FEN> | <score> | <result>' lines, score in centipawns and result 1/0.5/0, both for white" << endl;
+    cerr << "  chess-train train <positions.bin>... <network.nnue> [--epochs N] [--threads N] [--batch N] [--lr X] [--lambda X] [--seed N]" << endl;
+    cerr << "      trains a network on packed positions and exports it for the engine's 'nnue' command" << endl;
+    cerr << "  chess-train texel <positions>... <psqt_tables.h> [--iterations N] [--threads N] [--lr X] [--min-count N]" << endl;
+    cerr << "      tunes the material and piece-square values on the quiet positions of packed (.bin) or text/EPD files" << endl;
+}
+
+// reads a packed file, or a text file of positions if it doesn't end in .bin
+static bool readPositions(const string& path, vector<PackedPosition>& positions) {
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0) return readPackedPositions(path, positions);
+    long skipped = readTextPositions(path, positions);
+    if (skipped > 0) cout << "Skipped " << skipped << " malformed lines in " << path << endl;
+    return skipped >= 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    string command = argv[1];
+
+    if (command == "pack" && argc == 4) {
+        vector<PackedPosition> positions;
+        long skipped = readTextPositions(argv[2], positions);
+        if (skipped < 0) {
+            cerr << "Could not read " << argv[2] << endl;
+            return 1;
+        }
+        if (!writePackedPositions(argv[3], positions)) {
+            cerr << "Could not write " << argv[3] << endl;
+            return 1;
+        }
+        cout << "Packed " << positions.size() << " positions, skipped " << skipped << " malformed lines" << endl;
+        return 0;
+    }
+
+    if (command == "train") {
+        Trainer::Options options;
+        options.threads = max(1u, thread::hardware_concurrency());
+        vector<string> files;
+        for (int i = 2; i < argc; ++i) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--epochs" && hasValue) options.epochs = stoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = stoi(argv[++i]);
+            else if (arg == "--batch" && hasValue) options.batchSize = stoi(argv[++i]);
+            else if (arg == "--lr" && hasValue) options.learningRate = stof(argv[++i]);
+            else if (arg == "--lambda" && hasValue) options.lambda = stof(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = stoull(argv[++i]);
+            else if (arg.rfind("--", 0) == 0) {
+                printUsage();
+                return 1;
+            } else files.push_back(arg);
+        }
+        if (files.size() < 2 || options.epochs < 1 || options.threads < 1 || options.batchSize < 1) {
+            printUsage();
+            return 1;
+        }
+
+        string output = files.back();
+        files.pop_back();
+        vector<PackedPosition> positions;
+        for (const string& file : files) {
+            if (!readPackedPositions(file, positions)) {
+                cerr << "Could not read packed positions from " << file << endl;
+                return 1;
+            }
+        }
+        cout << "Training on " << positions.size() << " positions with " << options.threads << " threads" << endl;
+
+        Trainer trainer(options);
+        trainer.train(positions);
+        if (!trainer.exportNetwork(output)) {
+            cerr << "Could not write " << output << endl;
+            return 1;
+        }
+        cout << "Network written to " << output << endl;
+        return 0;
+    }
+
+    if (command == "texel") {
+        TexelTuner::Options options;
+        options.threads = max(1u, thread::hardware_concurrency());
+        vector<string> files;
+        for (int i = 2; i < argc; ++i) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--iterations" && hasValue) options.iterations = stoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = stoi(argv[++i]);
+            else if (arg == "--lr" && hasValue) options.learningRate = stof(argv[++i]);
+            else if (arg == "--min-count" && hasValue) options.minimumCount = stol(argv[++i]);
+            else if (arg.rfind("--", 0) == 0) {
+                printUsage();
+                return 1;
+            } else files.push_back(arg);
+        }
+        if (files.size() < 2 || options.iterations < 0 || options.threads < 1) {
+            printUsage();
+            return 1;
+        }
+
+        string output = files.back();
+        files.pop_back();
+        vector<PackedPosition> positions;
+        for (const string& file : files) {
+            if (!readPositions(file, positions)) {
+                cerr << "Could not read positions from " << file << endl;
+                return 1;
+            }
+        }
+
+        TexelTuner tuner(options);
+        size_t quiet = tuner.load(positions);
+        positions = vector<PackedPosition>(); // the tuner keeps its own copy of the quiet ones
+        cout << "Tuning on " << quiet << " quiet positions with " << options.threads << " threads" << endl;
+        if (quiet == 0) return 1;
+        double error = tuner.fitScale();
+        cout << "Starting error " << error << endl;
+        tuner.tune();
+        if (!tuner.exportTables(output)) {
+            cerr << "Could not write " << output << endl;
+            return 1;
+        }
+        cout << "Tables written to " << output << endl;
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
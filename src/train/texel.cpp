@@ -0,0 +1,303 @@
+#include "texel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "bitboard.h"
+#include "psqt.h"
+#include "psqt_tables.h"
+using namespace std;
+
+static const double ADAM_BETA1 = 0.9;
+static const double ADAM_BETA2 = 0.999;
+static const double ADAM_EPSILON = 1e-8;
+
+static const int exchangeValues[6] = {1, 3, 3, 5, 9, 100}; // rough piece values (p, n, b, r, q, k) for deciding whether a capture is pending
+static const char* const tableNames[6] = {"pawns", "knights", "bishops", "rooks", "queens", "kings"};
+
+static double sigmoid(double x) { return 1.0 / (1.0 + exp(-x)); }
+
+// runs work(0) .. work(threads - 1) at once, the last on the calling thread
+static void runParallel(int threads, const function<void(int)>& work) {
+    vector<thread> workers;
+    for (int t = 0; t < threads - 1; ++t) workers.emplace_back(work, t);
+    work(threads - 1);
+    for (thread& worker : workers) worker.join();
+}
+
+// a packed position's pieces as bitboards, [white = 0, black = 1][p, n, b, r, q, k]
+static void unpack(const PackedPosition& position, Bitboard pieces[2][6]) {
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int type = 0; type < 6; ++type) pieces[colour][type] = 0;
+    }
+    int index = 0;
+    for (Bitboard b = position.occupied; b; ) {
+        int sq = popLsb(b);
+        int code = position.piece(index++);
+        pieces[code / 6][code % 6] |= 1ULL << sq;
+    }
+}
+
+// pieces of one colour attacking a square
+static Bitboard attackers(const Bitboard pieces[2][6], int colour, int sq, Bitboard occupied) {
+    const Bitboard* own = pieces[colour];
+    return (Bitboards::pawnAttacks(colour != 0, sq) & own[0]) // a pawn attacks sq from where an opposing pawn on sq would attack
+         | (Bitboards::knightAttacks(sq) & own[1])
+         | (Bitboards::bishopAttacks(sq, occupied) & (own[2] | own[4]))
+         | (Bitboards::rookAttacks(sq, occupied) & (own[3] | own[4]))
+         | (Bitboards::kingAttacks(sq) & own[5]);
+}
+
+TexelTuner::TexelTuner(const Options& options)
+    : options(options), scale(400.0), midgame(PARAMETERS), endgame(PARAMETERS), occurrences(PARAMETERS, 0) {
+    // start from the engine's current values
+    for (int type = 0; type < 6; ++type) {
+        for (int sq = 0; sq < 64; ++sq) {
+            midgame[type * 64 + sq] = PSQT::midgame(true, "pnbrqk"[type], sq);
+            endgame[type * 64 + sq] = PSQT::endgame(true, "pnbrqk"[type], sq);
+        }
+    }
+}
+
+bool TexelTuner::isQuiet(const PackedPosition& position) {
+    Bitboard pieces[2][6];
+    unpack(position, pieces);
+
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int type = 0; type < 6; ++type) {
+            for (Bitboard b = pieces[colour][type]; b; ) {
+                int sq = popLsb(b);
+                Bitboard threats = attackers(pieces, 1 - colour, sq, position.occupied);
+                if (!threats) continue;
+                if (type == 5) return false; // in check
+                if (!attackers(pieces, colour, sq, position.occupied)) return false; // hanging
+                for (int attacker = 0; attacker < type; ++attacker) {
+                    if ((threats & pieces[1 - colour][attacker]) && exchangeValues[attacker] < exchangeValues[type]) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+size_t TexelTuner::load(const vector<PackedPosition>& positions) {
+    for (const PackedPosition& position : positions) {
+        if (!isQuiet(position)) continue;
+
+        Sample sample;
+        sample.count = 0;
+        int phase = 0;
+        int index = 0;
+        for (Bitboard b = position.occupied; b; ) {
+            int sq = popLsb(b);
+            int code = position.piece(index++);
+            int type = code % 6;
+            bool isWhite = code < 6;
+            int entry = type * 64 + (isWhite ? sq : sq ^ 56);
+            sample.pieces[sample.count++] = isWhite ? entry + 1 : -(entry + 1);
+            phase += PSQT::phase("pnbrqk"[type]);
+            occurrences[entry]++;
+        }
+        sample.phase = min(phase, (int)PSQT::MAX_PHASE);
+        sample.result = position.result / 2.0f;
+        samples.push_back(sample);
+    }
+    return samples.size();
+}
+
+double TexelTuner::evaluate(const Sample& sample) const {
+    double mg = 0, eg = 0;
+    for (int i = 0; i < sample.count; ++i) {
+        int piece = sample.pieces[i];
+        if (piece > 0) {
+            mg += midgame[piece - 1];
+            eg += endgame[piece - 1];
+        } else {
+            mg -= midgame[-piece - 1];
+            eg -= endgame[-piece - 1];
+        }
+    }
+    return (mg * sample.phase + eg * (PSQT::MAX_PHASE - sample.phase)) / PSQT::MAX_PHASE;
+}
+
+double TexelTuner::errorSum(size_t begin, size_t end, vector<double>* midgameGradient, vector<double>* endgameGradient) const {
+    double sum = 0;
+    for (size_t s = begin; s < end; ++s) {
+        const Sample& sample = samples[s];
+        double expected = sigmoid(evaluate(sample) / scale);
+        double difference = expected - sample.result;
+        sum += difference * difference;
+        if (!midgameGradient) continue;
+
+        // the score is linear in every entry, weighted by the phase
+        double dScore = 2 * difference * expected * (1 - expected) / scale;
+        double dMidgame = dScore * sample.phase / PSQT::MAX_PHASE;
+        double dEndgame = dScore - dMidgame;
+        for (int i = 0; i < sample.count; ++i) {
+            int piece = sample.pieces[i];
+            int entry = abs(piece) - 1;
+            double sign = piece > 0 ? 1 : -1;
+            (*midgameGradient)[entry] += sign * dMidgame;
+            (*endgameGradient)[entry] += sign * dEndgame;
+        }
+    }
+    return sum;
+}
+
+double TexelTuner::parallelError(vector<double>* midgameGradient, vector<double>* endgameGradient) const {
+    int threads = max(1, options.threads);
+    vector<double> sums(threads, 0.0);
+    vector<vector<double>> midgameGradients(midgameGradient ? threads : 0, vector<double>(PARAMETERS, 0.0));
+    vector<vector<double>> endgameGradients(midgameGradient ? threads : 0, vector<double>(PARAMETERS, 0.0));
+    runParallel(threads, [&](int t) {
+        size_t begin = samples.size() * t / threads, end = samples.size() * (t + 1) / threads;
+        sums[t] = midgameGradient ? errorSum(begin, end, &midgameGradients[t], &endgameGradients[t]) : errorSum(begin, end, nullptr, nullptr);
+    });
+
+    double total = 0;
+    for (double sum : sums) total += sum;
+    if (samples.empty()) return 0;
+    if (midgameGradient) {
+        for (int i = 0; i < PARAMETERS; ++i) {
+            (*midgameGradient)[i] = 0;
+            (*endgameGradient)[i] = 0;
+            for (int t = 0; t < threads; ++t) {
+                (*midgameGradient)[i] += midgameGradients[t][i] / samples.size();
+                (*endgameGradient)[i] += endgameGradients[t][i] / samples.size();
+            }
+        }
+    }
+    return total / samples.size();
+}
+
+double TexelTuner::error() const {
+    return parallelError(nullptr, nullptr);
+}
+
+double TexelTuner::fitScale() {
+    // golden-section search; the error is unimodal in the scale
+    const double ratio = (sqrt(5.0) - 1) / 2;
+    double low = 50, high = 2000;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    scale = a;
+    double errorA = error();
+    scale = b;
+    double errorB = error();
+    while (high - low > 1) {
+        if (errorA < errorB) {
+            high = b;
+            b = a;
+            errorB = errorA;
+            a = high - ratio * (high - low);
+            scale = a;
+            errorA = error();
+        } else {
+            low = a;
+            a = b;
+            errorA = errorB;
+            b = low + ratio * (high - low);
+            scale = b;
+            errorB = error();
+        }
+    }
+    scale = (low + high) / 2;
+    return error();
+}
+
+void TexelTuner::tune() {
+    vector<double> midgameGradient(PARAMETERS), endgameGradient(PARAMETERS);
+    vector<double> midgameM(PARAMETERS, 0.0), midgameV(PARAMETERS, 0.0), endgameM(PARAMETERS, 0.0), endgameV(PARAMETERS, 0.0);
+    int reportEvery = max(1, options.iterations / 10);
+
+    auto start = chrono::steady_clock::now();
+    for (int iteration = 1; iteration <= options.iterations; ++iteration) {
+        double currentError = parallelError(&midgameGradient, &endgameGradient);
+
+        double correction1 = 1 - pow(ADAM_BETA1, iteration), correction2 = 1 - pow(ADAM_BETA2, iteration);
+        for (int phase = 0; phase < 2; ++phase) {
+            vector<double>& values = phase == 0 ? midgame : endgame;
+            vector<double>& gradient = phase == 0 ? midgameGradient : endgameGradient;
+            vector<double>& m = phase == 0 ? midgameM : endgameM;
+            vector<double>& v = phase == 0 ? midgameV : endgameV;
+            for (int i = 0; i < PARAMETERS; ++i) {
+                if (!isTuned(i)) continue;
+                m[i] = ADAM_BETA1 * m[i] + (1 - ADAM_BETA1) * gradient[i];
+                v[i] = ADAM_BETA2 * v[i] + (1 - ADAM_BETA2) * gradient[i] * gradient[i];
+                values[i] -= options.learningRate * (m[i] / correction1) / (sqrt(v[i] / correction2) + ADAM_EPSILON);
+            }
+        }
+
+        if (iteration % reportEvery == 0 || iteration == options.iterations) {
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "iteration " << iteration << ": error " << currentError << ", "
+                 << (long)(samples.size() * (double)iteration / max(seconds, 1e-9)) << " positions/s" << endl;
+        }
+    }
+}
+
+bool TexelTuner::exportTables(const string& path) const {
+    ofstream file(path);
+    if (!file) return false;
+
+    // Each entry is tuned as material plus square bonus; the material is moved
+    // by the average change over the squares tuned, so the tables keep their
+    // shape and the others keep their old bonus. Kings carry none.
+    int pieceValues[2][6], tables[2][6][8][8];
+    for (int phase = 0; phase < 2; ++phase) {
+        const vector<double>& values = phase == 0 ? midgame : endgame;
+        const int* oldValues = phase == 0 ? midgamePieceValues : endgamePieceValues;
+        const int (*oldTables)[8][8] = phase == 0 ? midgameTables : endgameTables;
+        for (int type = 0; type < 6; ++type) {
+            double shift = 0;
+            int seen = 0;
+            for (int sq = 0; sq < 64; ++sq) {
+                if (!isTuned(type * 64 + sq)) continue;
+                shift += values[type * 64 + sq] - (oldValues[type] + oldTables[type][7 - sq / 8][sq % 8]);
+                seen++;
+            }
+            pieceValues[phase][type] = type == 5 || !seen ? oldValues[type] : oldValues[type] + (int)lround(shift / seen);
+            for (int sq = 0; sq < 64; ++sq) {
+                int& entry = tables[phase][type][7 - sq / 8][sq % 8];
+                entry = isTuned(type * 64 + sq) ? (int)lround(values[type * 64 + sq]) - pieceValues[phase][type] : oldTables[type][7 - sq / 8][sq % 8];
+            }
+        }
+    }
+
+    file << "#ifndef PSQT_TABLES_H\n#define PSQT_TABLES_H\n\n";
+    file << "/*\n";
+    file << " * Material and piece-square values read by PSQT::init, generated by\n";
+    file << " * `chess-train texel` from " << samples.size() << " quiet positions (mean squared\n";
+    file << " * error " << error() << ", sigmoid scale " << (int)lround(scale) << " centipawns). Regenerate rather\n";
+    file << " * than edit by hand.\n";
+    file << " *\n";
+    file << " * Piece values are in centipawns (p, n, b, r, q, k); the king is never\n";
+    file << " * traded, so it carries no material. Each table is laid out as the board is\n";
+    file << " * seen from white's side, rank 8 in the first row and rank 1 in the last;\n";
+    file << " * black uses the same tables mirrored.\n";
+    file << " */\n";
+    for (int phase = 0; phase < 2; ++phase) {
+        file << "\nstatic const int " << (phase == 0 ? "midgame" : "endgame") << "PieceValues[6] = {";
+        for (int type = 0; type < 6; ++type) file << (type ? ", " : "") << pieceValues[phase][type];
+        file << "};";
+    }
+    file << "\n";
+    for (int phase = 0; phase < 2; ++phase) {
+        file << "\nstatic const int " << (phase == 0 ? "midgame" : "endgame") << "Tables[6][8][8] = {\n";
+        for (int type = 0; type < 6; ++type) {
+            file << "    { // " << tableNames[type] << "\n";
+            for (int row = 0; row < 8; ++row) {
+                file << "        {";
+                for (int col = 0; col < 8; ++col) file << (col ? ", " : " ") << setw(3) << tables[phase][type][row][col];
+                file << " }" << (row < 7 ? "," : "") << "\n";
+            }
+            file << "    }" << (type < 5 ? "," : "") << "\n";
+        }
+        file << "};\n";
+    }
+    file << "\n#endif\n";
+    return (bool)file;
+}
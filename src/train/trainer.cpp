@@ -0,0 +1,391 @@
+#include "trainer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRAIN_X86 // the AVX2 kernels can be compiled; whether they run is decided by the CPU
+#endif
+using namespace std;
+
+static const float ADAM_BETA1 = 0.9f;
+static const float ADAM_BETA2 = 0.999f;
+static const float ADAM_EPSILON = 1e-8f;
+
+// largest weights that still fit their quantized types: int8 hidden weights, and int16 first-layer sums over every feature of a position
+static const float HIDDEN_WEIGHT_LIMIT = 127.0f / NNUE::WEIGHT_SCALE;
+static const float FEATURE_WEIGHT_LIMIT = 32767.0f / NNUE::ACTIVATION_SCALE / 32;
+static const float BIAS_LIMIT = 1e6f; // int32 biases have room to spare
+
+/*
+ * Vector kernels for the forward and backward passes, on lengths that are
+ * multiples of 8. The AVX2 versions are picked by the Trainer's constructor
+ * when the CPU has them; the scalar ones are left to the compiler.
+ */
+static void addScalar(float* y, const float* x, int n) {
+    for (int i = 0; i < n; ++i) y[i] += x[i];
+}
+
+static void axpyScalar(float* y, float a, const float* x, int n) {
+    for (int i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+static float dotScalar(const float* a, const float* b, int n) {
+    float sum = 0;
+    for (int i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+#ifdef TRAIN_X86
+__attribute__((target("avx2,fma")))
+static void addAVX2(float* y, const float* x, int n) {
+    for (int i = 0; i < n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void axpyAVX2(float* y, float a, const float* x, int n) {
+    __m256 scale = _mm256_set1_ps(a);
+    for (int i = 0; i < n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(scale, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+}
+
+// two independent sums, so consecutive multiply-adds don't wait on each other
+__attribute__((target("avx2,fma")))
+static float dotAVX2(const float* a, const float* b, int n) {
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+    }
+    if (i < n) sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+    __m256 sum = _mm256_add_ps(sum0, sum1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+    return _mm_cvtss_f32(half);
+}
+#endif
+
+static void (*vectorAdd)(float* y, const float* x, int n) = addScalar;
+static void (*vectorAxpy)(float* y, float a, const float* x, int n) = axpyScalar;
+static float (*vectorDot)(const float* a, const float* b, int n) = dotScalar;
+
+static float sigmoid(float x) { return 1.0f / (1.0f + exp(-x)); }
+static bool inClipRange(float x) { return x > 0.0f && x < 1.0f; } // where a clipped ReLU passes gradients through
+static float clip(float x) { return min(1.0f, max(0.0f, x)); }
+
+// runs work(0) .. work(threads - 1) in parallel, the last on the calling thread
+static void runParallel(int threads, const function<void(int)>& work) {
+    vector<thread> workers;
+    for (int t = 0; t < threads - 1; ++t) workers.emplace_back(work, t);
+    work(threads - 1);
+    for (thread& worker : workers) worker.join();
+}
+
+Trainer::DenseGradients::DenseGradients()
+    : featureBiases(HALF), hidden1Weights(HIDDEN * 2 * HALF), hidden1Biases(HIDDEN), hidden2Weights(HIDDEN * HIDDEN),
+      hidden2Biases(HIDDEN), outputWeights(HIDDEN), outputBias(1), loss(0) {}
+
+void Trainer::DenseGradients::clear() {
+    for (vector<float>* g : {&featureBiases, &hidden1Weights, &hidden1Biases, &hidden2Weights, &hidden2Biases, &outputWeights, &outputBias}) {
+        fill(g->begin(), g->end(), 0.0f);
+    }
+    loss = 0;
+}
+
+Trainer::Trainer(const Options& options)
+    : options(options), featureWeights((size_t)INPUTS * HALF), featureBiases(HALF), hidden1Weights(HIDDEN * 2 * HALF),
+      hidden1Biases(HIDDEN), hidden2Weights(HIDDEN * HIDDEN), hidden2Biases(HIDDEN), outputWeights(HIDDEN), outputBias(1), step(0) {
+#ifdef TRAIN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        vectorAdd = addAVX2;
+        vectorAxpy = axpyAVX2;
+        vectorDot = dotAVX2;
+    }
+#endif
+
+    // Small random weights, scaled by each layer's fan-in; first-layer biases
+    // start halfway up the clipped ReLU so its units begin in the active range
+    mt19937_64 random(options.seed);
+    auto initialize = [&random](vector<float>& values, float range) {
+        uniform_real_distribution<float> distribution(-range, range);
+        for (float& value : values) value = distribution(random);
+    };
+    initialize(featureWeights.values, 0.1f);
+    fill(featureBiases.values.begin(), featureBiases.values.end(), 0.5f);
+    initialize(hidden1Weights.values, 1.0f / sqrt(2.0f * HALF));
+    initialize(hidden2Weights.values, 1.0f / sqrt((float)HIDDEN));
+    initialize(outputWeights.values, 1.0f / sqrt((float)HIDDEN));
+}
+
+void Trainer::extractFeatures(const PackedPosition& position, Features& features) {
+    int squares[32], codes[32], count = 0;
+    int kingSq[2] = {0, 0};
+    for (Bitboard b = position.occupied; b; ++count) {
+        squares[count] = popLsb(b);
+        codes[count] = position.piece(count);
+        if (codes[count] % 6 == 5) kingSq[codes[count] / 6] = squares[count];
+    }
+
+    features.count[0] = features.count[1] = 0;
+    for (int i = 0; i < count; ++i) {
+        int colour = codes[i] / 6, type = codes[i] % 6;
+        if (type == 5) continue;
+        for (int perspective = 0; perspective < 2; ++perspective) {
+            features.index[perspective][features.count[perspective]++] = NNUE::featureIndex(perspective, kingSq[perspective], colour, type, squares[i]);
+        }
+    }
+}
+
+float Trainer::target(const PackedPosition& position) const {
+    return options.lambda * sigmoid(position.score / options.scoreScale) + (1.0f - options.lambda) * position.result / 2.0f;
+}
+
+void Trainer::forward(const Features& features, Activations& activations) const {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        float* sums = activations.accumulator + perspective * HALF;
+        memcpy(sums, featureBiases.values.data(), sizeof(float) * HALF);
+        for (int k = 0; k < features.count[perspective]; ++k) {
+            vectorAdd(sums, &featureWeights.values[(size_t)features.index[perspective][k] * HALF], HALF);
+        }
+    }
+    for (int i = 0; i < 2 * HALF; ++i) activations.input[i] = clip(activations.accumulator[i]);
+
+    for (int o = 0; o < HIDDEN; ++o) {
+        activations.hidden1Sum[o] = hidden1Biases.values[o] + vectorDot(&hidden1Weights.values[o * 2 * HALF], activations.input, 2 * HALF);
+        activations.hidden1[o] = clip(activations.hidden1Sum[o]);
+    }
+    for (int o = 0; o < HIDDEN; ++o) {
+        activations.hidden2Sum[o] = hidden2Biases.values[o] + vectorDot(&hidden2Weights.values[o * HIDDEN], activations.hidden1, HIDDEN);
+        activations.hidden2[o] = clip(activations.hidden2Sum[o]);
+    }
+    activations.output = outputBias.values[0] + vectorDot(outputWeights.values.data(), activations.hidden2, HIDDEN);
+}
+
+void Trainer::backpropagate(const vector<PackedPosition>& batch, const vector<Features>& features, size_t begin, size_t end,
+                            DenseGradients& gradients, vector<float>& accumulatorGradients) const {
+    Activations a;
+    for (size_t s = begin; s < end; ++s) {
+        forward(features[s], a);
+
+        // squared error of the win probabilities; its gradient through the sigmoid, per pawn of output
+        float prediction = sigmoid(a.output * 100.0f / options.scoreScale);
+        float error = prediction - target(batch[s]);
+        gradients.loss += error * error;
+        float dOutput = 2.0f * error * prediction * (1.0f - prediction) * 100.0f / options.scoreScale;
+
+        gradients.outputBias[0] += dOutput;
+        vectorAxpy(gradients.outputWeights.data(), dOutput, a.hidden2, HIDDEN);
+
+        alignas(32) float dHidden1[HIDDEN] = {};
+        for (int o = 0; o < HIDDEN; ++o) {
+            if (!inClipRange(a.hidden2Sum[o])) continue;
+            float d = dOutput * outputWeights.values[o];
+            gradients.hidden2Biases[o] += d;
+            vectorAxpy(&gradients.hidden2Weights[o * HIDDEN], d, a.hidden1, HIDDEN);
+            vectorAxpy(dHidden1, d, &hidden2Weights.values[o * HIDDEN], HIDDEN);
+        }
+
+        alignas(32) float dInput[2 * HALF] = {};
+        for (int o = 0; o < HIDDEN; ++o) {
+            if (!inClipRange(a.hidden1Sum[o])) continue;
+            float d = dHidden1[o];
+            gradients.hidden1Biases[o] += d;
+            vectorAxpy(&gradients.hidden1Weights[o * 2 * HALF], d, a.input, 2 * HALF);
+            vectorAxpy(dInput, d, &hidden1Weights.values[o * 2 * HALF], 2 * HALF);
+        }
+
+        // both perspectives start from the same biases
+        float* dAccumulator = &accumulatorGradients[s * 2 * HALF];
+        for (int i = 0; i < 2 * HALF; ++i) dAccumulator[i] = inClipRange(a.accumulator[i]) ? dInput[i] : 0.0f;
+        vectorAdd(gradients.featureBiases.data(), dAccumulator, HALF);
+        vectorAdd(gradients.featureBiases.data(), dAccumulator + HALF, HALF);
+    }
+}
+
+void Trainer::adamUpdate(Parameters& parameters, size_t begin, size_t end, float gradientScale, float limit) {
+    float rate = options.learningRate * sqrt(1.0f - pow(ADAM_BETA2, (float)step)) / (1.0f - pow(ADAM_BETA1, (float)step));
+    for (size_t i = begin; i < end; ++i) {
+        float g = parameters.gradient[i] * gradientScale;
+        parameters.gradient[i] = 0.0f;
+        parameters.m[i] = ADAM_BETA1 * parameters.m[i] + (1.0f - ADAM_BETA1) * g;
+        parameters.v[i] = ADAM_BETA2 * parameters.v[i] + (1.0f - ADAM_BETA2) * g * g;
+        float value = parameters.values[i] - rate * parameters.m[i] / (sqrt(parameters.v[i]) + ADAM_EPSILON);
+        parameters.values[i] = max(-limit, min(limit, value));
+    }
+}
+
+double Trainer::trainBatch(const vector<PackedPosition>& batch) {
+    size_t n = batch.size();
+    int threads = max(1, options.threads);
+    batchFeatures.resize(n);
+    accumulatorGradients.resize(n * 2 * HALF);
+    threadGradients.resize(threads);
+    step++;
+
+    // Positions are split between threads, each summing its own gradients
+    runParallel(threads, [&](int t) {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        for (size_t s = begin; s < end; ++s) extractFeatures(batch[s], batchFeatures[s]);
+        threadGradients[t].clear();
+        backpropagate(batch, batchFeatures, begin, end, threadGradients[t], accumulatorGradients);
+    });
+
+    double batchLoss = 0;
+    DenseGradients& sum = threadGradients[0];
+    for (int t = 0; t < threads; ++t) {
+        batchLoss += threadGradients[t].loss;
+        if (t == 0) continue;
+        vectorAdd(sum.featureBiases.data(), threadGradients[t].featureBiases.data(), HALF);
+        vectorAdd(sum.hidden1Weights.data(), threadGradients[t].hidden1Weights.data(), HIDDEN * 2 * HALF);
+        vectorAdd(sum.hidden1Biases.data(), threadGradients[t].hidden1Biases.data(), HIDDEN);
+        vectorAdd(sum.hidden2Weights.data(), threadGradients[t].hidden2Weights.data(), HIDDEN * HIDDEN);
+        vectorAdd(sum.hidden2Biases.data(), threadGradients[t].hidden2Biases.data(), HIDDEN);
+        vectorAdd(sum.outputWeights.data(), threadGradients[t].outputWeights.data(), HIDDEN);
+        sum.outputBias[0] += threadGradients[t].outputBias[0];
+    }
+
+    float scale = 1.0f / n;
+    featureBiases.gradient = sum.featureBiases;
+    hidden1Weights.gradient = sum.hidden1Weights;
+    hidden1Biases.gradient = sum.hidden1Biases;
+    hidden2Weights.gradient = sum.hidden2Weights;
+    hidden2Biases.gradient = sum.hidden2Biases;
+    outputWeights.gradient = sum.outputWeights;
+    outputBias.gradient = sum.outputBias;
+    adamUpdate(featureBiases, 0, HALF, scale, FEATURE_WEIGHT_LIMIT);
+    adamUpdate(hidden1Weights, 0, HIDDEN * 2 * HALF, scale, HIDDEN_WEIGHT_LIMIT);
+    adamUpdate(hidden1Biases, 0, HIDDEN, scale, BIAS_LIMIT);
+    adamUpdate(hidden2Weights, 0, HIDDEN * HIDDEN, scale, HIDDEN_WEIGHT_LIMIT);
+    adamUpdate(hidden2Biases, 0, HIDDEN, scale, BIAS_LIMIT);
+    adamUpdate(outputWeights, 0, HIDDEN, scale, HIDDEN_WEIGHT_LIMIT);
+    adamUpdate(outputBias, 0, 1, scale, BIAS_LIMIT);
+
+    // First-layer rows are only touched for the features present in the
+    // batch. Threads own disjoint column ranges of every row, so they sum the
+    // positions' gradients into the rows and update them without locking
+    touchedFeatures.clear();
+    featureTouched.resize(INPUTS);
+    for (size_t s = 0; s < n; ++s) {
+        for (int perspective = 0; perspective < 2; ++perspective) {
+            for (int k = 0; k < batchFeatures[s].count[perspective]; ++k) {
+                int feature = batchFeatures[s].index[perspective][k];
+                if (!featureTouched[feature]) {
+                    featureTouched[feature] = true;
+                    touchedFeatures.push_back(feature);
+                }
+            }
+        }
+    }
+
+    runParallel(threads, [&](int t) {
+        int first = HALF / 16 * t / threads * 16, last = HALF / 16 * (t + 1) / threads * 16; // whole cache lines of 16 columns
+        if (first == last) return;
+        for (size_t s = 0; s < n; ++s) {
+            for (int perspective = 0; perspective < 2; ++perspective) {
+                const float* dAccumulator = &accumulatorGradients[(s * 2 + perspective) * HALF + first];
+                for (int k = 0; k < batchFeatures[s].count[perspective]; ++k) {
+                    vectorAdd(&featureWeights.gradient[(size_t)batchFeatures[s].index[perspective][k] * HALF + first], dAccumulator, last - first);
+                }
+            }
+        }
+        for (int feature : touchedFeatures) {
+            size_t row = (size_t)feature * HALF;
+            adamUpdate(featureWeights, row + first, row + last, scale, FEATURE_WEIGHT_LIMIT);
+        }
+    });
+    for (int feature : touchedFeatures) featureTouched[feature] = false;
+
+    return batchLoss;
+}
+
+double Trainer::loss(const vector<PackedPosition>& positions) const {
+    int threads = max(1, options.threads);
+    vector<double> sums(threads, 0.0);
+    runParallel(threads, [&](int t) {
+        Features features;
+        Activations activations;
+        for (size_t s = positions.size() * t / threads; s < positions.size() * (t + 1) / threads; ++s) {
+            extractFeatures(positions[s], features);
+            forward(features, activations);
+            float error = sigmoid(activations.output * 100.0f / options.scoreScale) - target(positions[s]);
+            sums[t] += error * error;
+        }
+    });
+    double total = 0;
+    for (double sum : sums) total += sum;
+    return positions.empty() ? 0 : total / positions.size();
+}
+
+void Trainer::train(vector<PackedPosition> positions) {
+    mt19937_64 random(options.seed);
+    shuffle(positions.begin(), positions.end(), random);
+    size_t validationSize = (size_t)(positions.size() * options.validationFraction);
+    vector<PackedPosition> validation(positions.end() - validationSize, positions.end());
+    positions.resize(positions.size() - validationSize);
+
+    vector<PackedPosition> batch;
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        shuffle(positions.begin(), positions.end(), random);
+        auto start = chrono::steady_clock::now();
+        double totalLoss = 0;
+        for (size_t first = 0; first < positions.size(); first += options.batchSize) {
+            size_t last = min(positions.size(), first + (size_t)options.batchSize);
+            batch.assign(positions.begin() + first, positions.begin() + last);
+            totalLoss += trainBatch(batch);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << "epoch " << epoch << ": loss " << totalLoss / max((size_t)1, positions.size());
+        if (!validation.empty()) cout << ", validation " << loss(validation);
+        cout << ", " << (long)(positions.size() / max(seconds, 1e-9)) << " positions/s" << endl;
+    }
+}
+
+// rounds a weight to its quantized integer, saturating at the type's range
+template <typename T>
+static T quantize(float value, float scale) {
+    double scaled = round((double)value * scale);
+    return (T)max((double)numeric_limits<T>::min(), min((double)numeric_limits<T>::max(), scaled));
+}
+
+template <typename T>
+static void writeQuantized(ofstream& file, const vector<float>& values, float scale) {
+    vector<T> quantized(values.size());
+    for (size_t i = 0; i < values.size(); ++i) quantized[i] = quantize<T>(values[i], scale);
+    file.write(reinterpret_cast<const char*>(quantized.data()), quantized.size() * sizeof(T));
+}
+
+bool Trainer::exportNetwork(const string& path) const {
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+
+    char header[NNUE::HEADER_SIZE] = {};
+    uint32_t dimensions[4] = {NNUE::FILE_VERSION, (uint32_t)INPUTS, (uint32_t)HALF, (uint32_t)HIDDEN};
+    memcpy(header, NNUE::MAGIC, 4);
+    memcpy(header + 4, dimensions, sizeof(dimensions));
+    file.write(header, sizeof(header));
+
+    const float activation = NNUE::ACTIVATION_SCALE, weight = NNUE::WEIGHT_SCALE;
+    writeQuantized<int16_t>(file, featureBiases.values, activation);
+    writeQuantized<int16_t>(file, featureWeights.values, activation);
+    writeQuantized<int32_t>(file, hidden1Biases.values, activation * weight);
+    writeQuantized<int8_t>(file, hidden1Weights.values, weight);
+    writeQuantized<int32_t>(file, hidden2Biases.values, activation * weight);
+    writeQuantized<int8_t>(file, hidden2Weights.values, weight);
+    writeQuantized<int8_t>(file, outputWeights.values, weight);
+    writeQuantized<int32_t>(file, outputBias.values, activation * weight);
+    return (bool)file;
+}
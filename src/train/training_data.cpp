@@ -0,0 +1,107 @@
+#include "training_data.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+bool packPosition(const string& fen, int score, double result, PackedPosition& position) {
+    memset(&position, 0, sizeof(position));
+
+    // board codes by square first, as the FEN lists rank 8 first but pieces are packed from a1 upwards
+    int codes[64];
+    for (int sq = 0; sq < 64; ++sq) codes[sq] = -1;
+    int row = 7, col = 0;
+    for (char c : fen) {
+        if (c == ' ') break;
+        if (c == '/') {
+            if (col != 8 || row == 0) return false;
+            row--;
+            col = 0;
+        } else if (isdigit(c)) {
+            col += c - '0';
+        } else {
+            const char* types = "pnbrqk";
+            const char* type = strchr(types, tolower(c));
+            if (!type || col > 7) return false;
+            codes[row * 8 + col] = (isupper(c) ? 0 : 6) + (type - types);
+            col++;
+        }
+        if (col > 8) return false;
+    }
+    if (row != 0 || col != 8) return false;
+    if (count(codes, codes + 64, 5) != 1 || count(codes, codes + 64, 11) != 1) return false; // the network's features need both kings
+
+    int count = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        if (codes[sq] < 0) continue;
+        if (count == 32) return false;
+        position.occupied |= 1ULL << sq;
+        position.setPiece(count++, codes[sq]);
+    }
+    position.score = (int16_t)max(-32000, min(32000, score));
+    position.result = result > 0.75 ? 2 : result > 0.25 ? 1 : 0;
+    return true;
+}
+
+// finds an EPD line's game result, quoted as "1-0", "1/2-1/2" or "0-1" or bracketed as [1.0], [0.5] or [0.0]
+static bool parseEpdResult(const string& line, double& result) {
+    static const char* const results[3] = {"\"0-1\"", "\"1/2-1/2\"", "\"1-0\""};
+    for (int i = 0; i < 3; ++i) {
+        if (line.find(results[i]) != string::npos) {
+            result = i / 2.0;
+            return true;
+        }
+    }
+    size_t open = line.rfind('[');
+    return open != string::npos && (bool)(istringstream(line.substr(open + 1)) >> result) && result >= 0 && result <= 1;
+}
+
+long readTextPositions(const string& path, vector<PackedPosition>& positions) {
+    ifstream file(path);
+    if (!file) return -1;
+
+    long skipped = 0;
+    string line;
+    while (getline(file, line)) {
+        if (line.empty()) continue;
+        size_t first = line.find('|');
+        size_t second = first == string::npos ? string::npos : line.find('|', first + 1);
+        int score = 0;
+        double result;
+        PackedPosition position;
+        bool parsed;
+        if (first == string::npos) {
+            parsed = parseEpdResult(line, result) && packPosition(line, score, result, position);
+        } else {
+            parsed = second != string::npos &&
+                     (bool)(istringstream(line.substr(first + 1, second - first - 1)) >> score) &&
+                     (bool)(istringstream(line.substr(second + 1)) >> result) &&
+                     packPosition(line.substr(0, first), score, result, position);
+        }
+        if (!parsed) {
+            skipped++;
+            continue;
+        }
+        positions.push_back(position);
+    }
+    return skipped;
+}
+
+bool readPackedPositions(const string& path, vector<PackedPosition>& positions) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) return false;
+    streamsize bytes = file.tellg();
+    if (bytes % sizeof(PackedPosition) != 0) return false;
+    file.seekg(0);
+    size_t start = positions.size();
+    positions.resize(start + bytes / sizeof(PackedPosition));
+    return (bool)file.read(reinterpret_cast<char*>(positions.data() + start), bytes);
+}
+
+bool writePackedPositions(const string& path, const vector<PackedPosition>& positions) {
+    ofstream file(path, ios::binary);
+    if (!file) return false;
+    return (bool)file.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(PackedPosition));
+}
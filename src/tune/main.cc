@@ -0,0 +1,77 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "advanced_ai.h"
+#include "nnue.h"
+#include "spsa.h"
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage:" << endl;
+    cerr << "  chess-tune parameters" << endl;
+    cerr << "      lists the engine's tunable search parameters with their values and ranges" << endl;
+    cerr << "  chess-tune spsa [--iterations N] [--threads N] [--pairs N] [--nodes N] [--opening-plies N] [--perturbation X] [--lr X] [--seed N] [--nnue FILE]" << endl;
+    cerr << "      tunes them by SPSA over node-limited self-play games, --pairs game pairs per iteration" << endl;
+}
+
+static void printParameters(const vector<AdvancedAI::Parameter>& parameters) {
+    for (const AdvancedAI::Parameter& parameter : parameters) {
+        cout << parameter.name << " " << parameter.value << " [" << parameter.min << ", " << parameter.max << "]" << endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    string command = argv[1];
+    AdvancedAI defaults(true);
+
+    if (command == "parameters" && argc == 2) {
+        printParameters(defaults.getParameters());
+        return 0;
+    }
+
+    if (command == "spsa") {
+        SPSATuner::Options options;
+        options.threads = max(1u, thread::hardware_concurrency());
+        for (int i = 2; i < argc; ++i) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--iterations" && hasValue) options.iterations = stoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = stoi(argv[++i]);
+            else if (arg == "--pairs" && hasValue) options.pairsPerIteration = stoi(argv[++i]);
+            else if (arg == "--nodes" && hasValue) options.nodesPerMove = stoull(argv[++i]);
+            else if (arg == "--opening-plies" && hasValue) options.openingPlies = stoi(argv[++i]);
+            else if (arg == "--perturbation" && hasValue) options.perturbation = stod(argv[++i]);
+            else if (arg == "--lr" && hasValue) options.learningRate = stod(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = stoull(argv[++i]);
+            else if (arg == "--nnue" && hasValue) {
+                if (!NNUE::load(argv[++i])) {
+                    cerr << "Could not load network " << argv[i] << endl;
+                    return 1;
+                }
+            } else {
+                printUsage();
+                return 1;
+            }
+        }
+        if (options.iterations < 1 || options.threads < 1 || options.pairsPerIteration < 1 || options.nodesPerMove < 1 || options.openingPlies < 0) {
+            printUsage();
+            return 1;
+        }
+
+        cout << "Tuning with " << options.threads << " threads, " << options.pairsPerIteration << " game pairs per iteration, "
+             << options.nodesPerMove << " nodes per move" << endl;
+        SPSATuner tuner(options, defaults.getParameters());
+        tuner.tune();
+        cout << "Tuned values:" << endl;
+        printParameters(tuner.result());
+        return 0;
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,203 @@
+#include "spsa.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+// Spall's recommended decay exponents for the step and perturbation gains
+static const double ALPHA = 0.602;
+static const double GAMMA = 0.101;
+
+// adjudication, on the scores of the searches that chose the moves
+static const int RESIGN_SCORE = 600; // centipawns, for either side
+static const int RESIGN_PLIES = 8; // consecutive plies both engines must see the game as lost
+static const int DRAW_SCORE = 10;
+static const int DRAW_PLIES = 16;
+static const int DRAW_MIN_PLY = 80; // openings and middlegames are always played on
+
+// runs work(0) .. work(threads - 1) at once, the last on the calling thread
+static void runParallel(int threads, const function<void(int)>& work) {
+    vector<thread> workers;
+    for (int t = 0; t < threads - 1; ++t) workers.emplace_back(work, t);
+    work(threads - 1);
+    for (thread& worker : workers) worker.join();
+}
+
+// rounds up with a probability equal to the fraction, so small perturbations of integer parameters are right on average
+static int stochasticRound(double value, mt19937_64& random) {
+    double low = floor(value);
+    return (int)low + (uniform_real_distribution<double>(0.0, 1.0)(random) < value - low ? 1 : 0);
+}
+
+SPSATuner::SPSATuner(const Options& options, const vector<AdvancedAI::Parameter>& parameters)
+    : options(options), stabilityConstant(0.1 * options.iterations) {
+    // gains chosen so the run ends with perturbations of `perturbation` of each range and steps of learningRate * c^2
+    for (const AdvancedAI::Parameter& parameter : parameters) {
+        double cEnd = (parameter.max - parameter.min) * options.perturbation;
+        double aEnd = options.learningRate * cEnd * cEnd;
+        tuned.push_back(Tuned{parameter, (double)parameter.value,
+                              cEnd * pow(options.iterations, GAMMA),
+                              aEnd * pow(stabilityConstant + options.iterations, ALPHA)});
+    }
+
+    threadEngines.resize(max(1, options.threads));
+    for (Engines& engines : threadEngines) {
+        for (int colour = 0; colour < 2; ++colour) {
+            engines.engine[colour] = make_unique<AdvancedAI>(colour == 0, 8);
+            AdvancedAI& engine = *engines.engine[colour];
+            engine.setMaxDepth(32);
+            engine.setTimeLimit(INT_MAX); // the node limit ends every search
+            engine.setNodeLimit(options.nodesPerMove);
+            engine.setVerbose(false);
+        }
+    }
+}
+
+void SPSATuner::setupStartPosition(ChessBoard& board) {
+    const char backRank[8] = {'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r'};
+    for (int col = 0; col < 8; ++col) {
+        board.placePiece(0, col, true, backRank[col]);
+        board.placePiece(1, col, true, 'p');
+        board.placePiece(6, col, false, 'p');
+        board.placePiece(7, col, false, backRank[col]);
+    }
+}
+
+vector<SPSATuner::OpeningMove> SPSATuner::randomOpening(mt19937_64& random) const {
+    while (true) {
+        ChessBoard board(nullptr, nullptr);
+        setupStartPosition(board);
+        vector<OpeningMove> opening;
+        bool whiteToMove = true;
+        for (int ply = 0; ply < options.openingPlies; ++ply) {
+            vector<OpeningMove> moves;
+            for (Bitboard pieces = board.getPieces(whiteToMove); pieces; ) {
+                int from = popLsb(pieces);
+                for (int to = 0; to < 64; ++to) {
+                    bool promotes = (board.getPieces(whiteToMove, 'p') & (1ULL << from)) && (to / 8 == 0 || to / 8 == 7);
+                    if (!promotes && board.verifyMove(from / 8, from % 8, to / 8, to % 8, whiteToMove)) {
+                        moves.push_back(OpeningMove{from / 8, from % 8, to / 8, to % 8});
+                    }
+                }
+            }
+            if (moves.empty()) break;
+            OpeningMove move = moves[random() % moves.size()];
+            board.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+            opening.push_back(move);
+            whiteToMove = !whiteToMove;
+        }
+        if ((int)opening.size() == options.openingPlies) return opening; // otherwise the game ended in the opening, try another
+    }
+}
+
+void SPSATuner::configure(AdvancedAI& engine, const vector<int>& values) const {
+    for (size_t i = 0; i < tuned.size(); ++i) engine.setParameter(tuned[i].parameter.name, values[i]);
+    engine.newGame();
+}
+
+double SPSATuner::playGame(Engines& engines, const vector<OpeningMove>& opening) const {
+    ChessBoard board(nullptr, nullptr);
+    setupStartPosition(board);
+    for (const OpeningMove& move : opening) board.movePiece(move.fromRow, move.fromCol, move.toRow, move.toCol);
+    bool whiteToMove = opening.size() % 2 == 0;
+
+    int winningPlies = 0, losingPlies = 0, drawnPlies = 0; // consecutive plies with white's score past each threshold
+    for (int ply = 0; ply < options.maxPlies; ++ply) {
+        AdvancedAI& engine = *engines.engine[whiteToMove ? 0 : 1];
+        if (!engine.makeMove(board)) {
+            if (board.checkIfKingIsInCheck(whiteToMove)) return whiteToMove ? 0.0 : 1.0;
+            return 0.5;
+        }
+        if (board.isRepetition(2) || board.isFiftyMoveDraw()) return 0.5;
+
+        int score = engine.getLastScore();
+        winningPlies = score >= RESIGN_SCORE ? winningPlies + 1 : 0;
+        losingPlies = score <= -RESIGN_SCORE ? losingPlies + 1 : 0;
+        drawnPlies = abs(score) <= DRAW_SCORE ? drawnPlies + 1 : 0;
+        if (winningPlies >= RESIGN_PLIES) return 1.0;
+        if (losingPlies >= RESIGN_PLIES) return 0.0;
+        if (drawnPlies >= DRAW_PLIES && ply >= DRAW_MIN_PLY) return 0.5;
+
+        whiteToMove = !whiteToMove;
+    }
+    return 0.5;
+}
+
+void SPSATuner::tune() {
+    int threads = (int)threadEngines.size();
+    int pairs = options.pairsPerIteration;
+    size_t count = tuned.size();
+    auto runStart = chrono::steady_clock::now();
+
+    for (int k = 1; k <= options.iterations; ++k) {
+        mt19937_64 iterationRandom(options.seed * 0x9E3779B97F4A7C15ULL + k);
+        vector<int> direction(count);
+        vector<double> plus(count), minus(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Tuned& t = tuned[i];
+            double ck = t.c / pow(k, GAMMA);
+            direction[i] = iterationRandom() & 1 ? 1 : -1;
+            plus[i] = min((double)t.parameter.max, max((double)t.parameter.min, t.value + ck * direction[i]));
+            minus[i] = min((double)t.parameter.max, max((double)t.parameter.min, t.value - ck * direction[i]));
+        }
+
+        // each pair draws its opening and roundings from a seed of its own, so results don't depend on which thread played it
+        vector<double> pairScores(pairs, 0.0);
+        atomic<int> nextPair(0);
+        auto start = chrono::steady_clock::now();
+        runParallel(threads, [&](int t) {
+            for (int p = nextPair++; p < pairs; p = nextPair++) {
+                mt19937_64 random(options.seed * 0xD1B54A32D192ED03ULL + (uint64_t)k * 0x10000 + p);
+                vector<int> plusValues(count), minusValues(count);
+                for (size_t i = 0; i < count; ++i) {
+                    plusValues[i] = stochasticRound(plus[i], random);
+                    minusValues[i] = stochasticRound(minus[i], random);
+                }
+                vector<OpeningMove> opening = randomOpening(random);
+
+                Engines& engines = threadEngines[t];
+                double score = 0; // for the plus engine, less the minus engine's
+                for (int plusIsWhite = 1; plusIsWhite >= 0; --plusIsWhite) {
+                    configure(*engines.engine[0], plusIsWhite ? plusValues : minusValues);
+                    configure(*engines.engine[1], plusIsWhite ? minusValues : plusValues);
+                    double whiteResult = playGame(engines, opening);
+                    double plusResult = plusIsWhite ? whiteResult : 1 - whiteResult;
+                    score += 2 * plusResult - 1;
+                }
+                pairScores[p] = score;
+            }
+        });
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double total = 0;
+        for (double score : pairScores) total += score;
+        for (size_t i = 0; i < count; ++i) {
+            Tuned& t = tuned[i];
+            double ck = t.c / pow(k, GAMMA);
+            double ak = t.a / pow(stabilityConstant + k, ALPHA);
+            t.value += ak / ck * total * direction[i];
+            t.value = min((double)t.parameter.max, max((double)t.parameter.min, t.value));
+        }
+
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+        cout << "iteration " << k << ": score " << total << "/" << 2 * pairs << ", " << seconds << " s, "
+             << 2.0 * pairs * k / max(elapsed, 1e-9) << " games/s |";
+        for (const Tuned& t : tuned) cout << " " << t.parameter.name << "=" << t.value;
+        cout << endl;
+    }
+}
+
+vector<AdvancedAI::Parameter> SPSATuner::result() const {
+    vector<AdvancedAI::Parameter> parameters;
+    for (const Tuned& t : tuned) {
+        AdvancedAI::Parameter parameter = t.parameter;
+        parameter.value = (int)lround(t.value);
+        parameters.push_back(parameter);
+    }
+    return parameters;
+}